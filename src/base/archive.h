@@ -0,0 +1,328 @@
+/*
+  archive.h
+
+  Firing Squad Synhronization Problem:
+     Binary archive of solutions.
+
+     The file is a header followed by records of fixed size:
+       header (32 bytes) : magic "FSSPARC1", version, number of states,
+                           number of useful rules, size of a record, 8 bytes reserved
+       record            : hash of the rules (uint64, see Solution::hash),
+                           fitness (int32, -1 for an invalid fitness),
+                           useful rules (see RuleTables::useful) packed with 3 bits by rule,
+                           padding to a multiple of 8 bytes.
+     The fixed and impossible rules are not stored (computed from the tables of the rules),
+     and the value 7 of a rule is UNUSED.
+     The integers are stored in the byte order of the machine (little endian on x86).
+
+     ArchiveWriter appends records with one write by record (O_APPEND),
+     so a search can add its solutions during the run.
+     ArchiveReader maps the file in memory, the records are read in place.
+     A partial record at the end of the file (interrupted write) is ignored by the reader,
+     and removed by the next writer.
+*/
+
+#ifndef __archive__h
+#define __archive__h
+
+#include <iostream>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <base/solution.h>
+
+/*********************************************
+ * format of the archive for a number of states
+ *
+ *********************************************/
+template <int NbStates>
+struct ArchiveFormat {
+  typedef States<NbStates> S;
+
+  static const uint32_t version = 1;
+
+  static const int headerSize = 32;
+
+  // bits by rule, and code of the UNUSED rules
+  static const int bitsByRule = 3;
+  static const int unusedCode = 7;
+
+  static const int rulesOffset = 12;
+
+  static constexpr int rulesSize() {
+    return (S::tables.nbUseful * bitsByRule + 7) / 8;
+  }
+
+  static constexpr int recordSize() {
+    return (rulesOffset + rulesSize() + 7) / 8 * 8;
+  }
+
+  static void writeHeader(uint8_t * h) {
+    uint32_t v;
+
+    memset(h, 0, headerSize);
+    memcpy(h, "FSSPARC1", 8);
+    v = version;            memcpy(h + 8, &v, 4);
+    v = NbStates;           memcpy(h + 12, &v, 4);
+    v = S::tables.nbUseful; memcpy(h + 16, &v, 4);
+    v = recordSize();       memcpy(h + 20, &v, 4);
+  }
+
+  static bool checkHeader(const uint8_t * h) {
+    uint8_t expected[headerSize];
+
+    writeHeader(expected);
+
+    return memcmp(h, expected, 24) == 0;
+  }
+
+  /*********************************************
+   * encode a solution into a record
+   *
+   *********************************************/
+  static void encode(const Solution<NbStates> & x, uint8_t * record) {
+    uint64_t hash = x.hash();
+    int32_t fitness = x.invalid() ? -1 : x.fitness();
+    int v, bit;
+
+    memset(record, 0, recordSize());
+    memcpy(record, &hash, 8);
+    memcpy(record + 8, &fitness, 4);
+
+    uint8_t * rules = record + rulesOffset;
+    for(int k = 0; k < S::tables.nbUseful; k++) {
+      v = x.rules[ S::tables.useful[k] ];
+      if (v == UNUSED)
+        v = unusedCode;
+
+      bit = k * bitsByRule;
+      rules[bit >> 3] |= v << (bit & 7);
+      if ((bit & 7) + bitsByRule > 8)
+        rules[(bit >> 3) + 1] |= v >> (8 - (bit & 7));
+    }
+  }
+
+  /*********************************************
+   * value of the k-th useful rule of a record
+   *
+   *********************************************/
+  static int rule(const uint8_t * record, int k) {
+    const uint8_t * rules = record + rulesOffset;
+    int bit = k * bitsByRule;
+    int v = rules[bit >> 3] >> (bit & 7);
+
+    if ((bit & 7) + bitsByRule > 8)
+      v |= rules[(bit >> 3) + 1] << (8 - (bit & 7));
+    v &= (1 << bitsByRule) - 1;
+
+    return (v == unusedCode) ? UNUSED : v;
+  }
+};
+
+/*********************************************
+ * record of an archive, read in place
+ *
+ *********************************************/
+template <int NbStates>
+class ArchiveRecord {
+public:
+  typedef ArchiveFormat<NbStates> Format;
+
+  ArchiveRecord(const uint8_t * _data) : data(_data) {
+  }
+
+  uint64_t hash() const {
+    uint64_t h;
+    memcpy(&h, data, 8);
+    return h;
+  }
+
+  // -1 for an invalid fitness
+  int fitness() const {
+    int32_t f;
+    memcpy(&f, data + 8, 4);
+    return f;
+  }
+
+  // value of the k-th useful rule
+  int rule(int k) const {
+    return Format::rule(data, k);
+  }
+
+  /*********************************************
+   * decode the record into a solution
+   *
+   * output : x : solution
+   *          return false when the hash of the rules is not the one of the record
+   *
+   *********************************************/
+  bool get(Solution<NbStates> & x) const {
+    // impossible and fixed rules
+    static const Solution<NbStates> fixed = fixedRules();
+
+    x = fixed;
+    for(int k = 0; k < States<NbStates>::tables.nbUseful; k++)
+      x.rules[ States<NbStates>::tables.useful[k] ] = rule(k);
+    x.rehash();
+
+    if (fitness() >= 0)
+      x.fitness(fitness());
+
+    return x.hash() == hash();
+  }
+
+private:
+  const uint8_t * data;
+
+  static Solution<NbStates> fixedRules() {
+    Solution<NbStates> x;
+    x.setFixedRules();
+    return x;
+  }
+};
+
+/*********************************************
+ * reader of an archive (memory map of the file)
+ *
+ *********************************************/
+template <int NbStates>
+class ArchiveReader {
+public:
+  typedef ArchiveFormat<NbStates> Format;
+
+  ArchiveReader(const char * fileName) : data(NULL), length(0), nbRecords(0) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "ArchiveReader: impossible to open " << fileName << std::endl;
+      return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= Format::headerSize) {
+      length = st.st_size;
+      void * p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED)
+        data = (const uint8_t *) p;
+    }
+    close(fd);
+
+    if (data == NULL || !Format::checkHeader(data)) {
+      std::cerr << "ArchiveReader: " << fileName << " is not an archive of " << NbStates << " states" << std::endl;
+      unmap();
+      return;
+    }
+
+    madvise((void *) data, length, MADV_SEQUENTIAL);
+
+    // the partial record at the end is ignored
+    nbRecords = (length - Format::headerSize) / Format::recordSize();
+  }
+
+  ~ArchiveReader() {
+    unmap();
+  }
+
+  bool isOpen() const {
+    return data != NULL;
+  }
+
+  size_t size() const {
+    return nbRecords;
+  }
+
+  ArchiveRecord<NbStates> operator[](size_t i) const {
+    return ArchiveRecord<NbStates>(data + Format::headerSize + i * Format::recordSize());
+  }
+
+private:
+  const uint8_t * data;
+  size_t length;
+  size_t nbRecords;
+
+  void unmap() {
+    if (data != NULL)
+      munmap((void *) data, length);
+    data = NULL;
+    nbRecords = 0;
+  }
+};
+
+/*********************************************
+ * writer of an archive: append the records at the end of the file
+ * (the file is created with its header when it does not exist)
+ *
+ *********************************************/
+template <int NbStates>
+class ArchiveWriter {
+public:
+  typedef ArchiveFormat<NbStates> Format;
+
+  ArchiveWriter(const char * fileName) {
+    fd = open(fileName, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+      std::cerr << "ArchiveWriter: impossible to open " << fileName << std::endl;
+      return;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+
+    if (st.st_size == 0) {
+      uint8_t header[Format::headerSize];
+      Format::writeHeader(header);
+      if (write(fd, header, Format::headerSize) != Format::headerSize)
+        std::cerr << "ArchiveWriter: impossible to write the header of " << fileName << std::endl;
+    } else {
+      uint8_t header[Format::headerSize];
+      if (pread(fd, header, Format::headerSize, 0) != Format::headerSize || !Format::checkHeader(header)) {
+        std::cerr << "ArchiveWriter: " << fileName << " is not an archive of " << NbStates << " states" << std::endl;
+        close(fd);
+        fd = -1;
+        return;
+      }
+
+      // partial record at the end of the file (interrupted write): removed
+      size_t partial = (st.st_size - Format::headerSize) % Format::recordSize();
+      if (partial != 0 && ftruncate(fd, st.st_size - partial) != 0)
+        std::cerr << "ArchiveWriter: impossible to remove the partial record of " << fileName << std::endl;
+    }
+  }
+
+  ~ArchiveWriter() {
+    if (fd >= 0)
+      close(fd);
+  }
+
+  bool isOpen() const {
+    return fd >= 0;
+  }
+
+  /*********************************************
+   * append a solution (one write)
+   *
+   * output : true when the record is written
+   *
+   *********************************************/
+  bool append(const Solution<NbStates> & x) {
+    uint8_t record[Format::recordSize()];
+
+    Format::encode(x, record);
+
+    return fd >= 0 && write(fd, record, Format::recordSize()) == Format::recordSize();
+  }
+
+  // the records are on the disk
+  void sync() {
+    if (fd >= 0)
+      fsync(fd);
+  }
+
+private:
+  int fd;
+};
+
+#endif
@@ -3,7 +3,7 @@
 
   Firing Squad Synhronization Problem:
      Cellular automata computation with objective function, and export into svg.
-     Design for 5 states, but could also be used with 6 states.
+     Specialized at compile time on the number of states (5 or 6).
 
 See for reference:
     Manuel Clergue, Sébastien Verel, Enrico Formenti, 
@@ -24,37 +24,50 @@ See for reference:
 #include <fstream>
 #include <vector>
 #include <time.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 // type of a solution
 #include <base/solution.h>
+// parallel evaluation of the neighborhood
+#include <base/threadPool.h>
+// random generator of the searches
+#include <base/random.h>
+// cache of the fitness values
+#include <base/fitnessCache.h>
+// optional counters of the evaluation (FSSP_COUNTERS)
+#include <base/counters.h>
+// checkpoints of the iterated local search
+#include <base/checkpoint.h>
+// export of the space-time diagram in PPM or PNG
+#include <base/raster.h>
+// vectorized update of the rows (SSSE3, AVX2, AVX-512)
+#include <base/rowKernel.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
 
-// Glocal constants, but could local somewhere for a better design...
-
-// number of states
-const int nbStates  = 5;
-
-// number of digit (including border)
-const int nbDigits  = nbStates + 1;
-const int nbDigits2 = nbDigits * nbDigits;
-
-// dimension of the tabular of the solution (of type Solution)
-const int nbRules   = nbDigits * nbDigits * nbDigits; // = 6^3 = 216
+using namespace std;
 
-// Notation for states
-const int REPOS = 0;
-const int GEN = 1;
-const int NONGEN = 2;
-const int NONGENBIS = 3;
-const int FIRE = nbStates - 1;
-const int BORD = nbStates;
+template <int NbStates>
+class Automata {
+public:
+  // number of states
+  static const int nbStates  = NbStates;
 
-const int UNUSED = 8;
-const int IMPOSSIBLE = 9;
+  // number of digit (including border)
+  static const int nbDigits  = States<NbStates>::nbDigits;
+  static const int nbDigits2 = States<NbStates>::nbDigits2;
 
+  // dimension of the tabular of the solution (of type Solution)
+  static const int nbRules   = States<NbStates>::nbRules; // = 6^3 = 216 for 5 states
 
-using namespace std;
+  static const int FIRE  = States<NbStates>::FIRE;
+  static const int BORD  = States<NbStates>::BORD;
+  static const int TRACE = States<NbStates>::TRACE;
 
-class Automata {
-public:
   /*********************************************
    * constructor
    *
@@ -62,17 +75,54 @@ public:
    *
    *********************************************/
   Automata(int _maxSize) : maxSize(_maxSize), maxIteration(2 * _maxSize - 2) {
-    int i;
-    
-    configs = new int*[maxIteration + 1];
-    for(i = 0; i <= maxIteration; i++)
-      configs[i] = new int[maxSize];
+    // one aligned buffer for the space-time diagram
+    size_t size = rowOffset(maxIteration + 1);
+    size = (size + 63) / 64 * 64;
+    configs = (uint8_t *) aligned_alloc(64, size);
     
     initialConfigurations();
     
     // trace
     trace = NULL;
     
+    // incremental evaluation
+    firstSize = new int[nbRules];
+    firstTime = new int[nbRules];
+    snapshots = NULL;
+    snapshotOffset = new size_t[maxSize + 1];
+    snapshotMaxSize = 0;
+    incrementalNMax = -1;
+    
+    // two cells by lookup
+    pairsBuilt = false;
+    pairsDirty = true;
+    pairsCost = -1;
+    kernelDirty = true;
+    
+    // parallel evaluation of the neighborhood
+    pool = NULL;
+    nbThreads = 0;
+    
+    // no cache of the fitness values
+    cache = NULL;
+    
+    nbCellUpdates = 0;
+    nbEvaluations = 0;
+    
+    // no stop of the searches before the number of iterations
+    stopFunction = nullptr;
+    
+    // parameters of the iterated local search
+    ilsStrength = 10;
+    ilsHillClimberIter = 10000;
+    
+    // mutations of all the useful rules
+    usedRulesOnly = false;
+    nbRedrawnMutations = 0;
+    
+    // one mutation evaluated at a time by the hill climber
+    speculation = 1;
+    
     // for drawing
     width  = 10;
     height = 10;
@@ -89,10 +139,15 @@ public:
     if (trace != NULL)
       delete [] trace;
     
-    for(int i = 0; i <= maxIteration; i++)
-      delete [] configs[i];
-
-    delete [] configs;
+    delete [] firstSize;
+    delete [] firstTime;
+    if (snapshots != NULL)
+      delete [] snapshots;
+    delete [] snapshotOffset;
+    
+    deleteWorkspaces();
+    
+    free(configs);
   }
 
   /*********************************************
@@ -105,22 +160,33 @@ public:
    * output : the maximum size solved
    *
    *********************************************/
-  void eval(Solution & x, int nMax) {
+  void eval(Solution<NbStates> & x, int nMax) {
     int nMin = 2; // in this version.
 
+    // the size nMax + 1 is computed, it has to fit into the diagram
+    if (nMax > maxSize - 1)
+      nMax = maxSize - 1;
+
+    FSSP_COUNT(evalCounters().evaluations++;)
+    nbEvaluations++;
+
+    int f;
+    if (cache != NULL && cache->nMax() == nMax && cache->find(x.hash(), f)) {
+      x.fitness(f);
+      return;
+    }
+
     // nous supposons que la regle est faite pour que la longueur n = nMin fonctionne
     int nbFireTot = nMin;
     
     int k = nMin;
     
-    if (trace == NULL) {
-      createTrace(x.rules, nMin);
-    } else {
-      // load from the trace
-      for(int i = 0; i < nMin - 1; i++) {
-        configs[2 * nMin - 3 - i][i] = trace[i];
-      }
-    }
+    loadTrace(x.rules, nMin);
+
+    // the rules may have been modified since the last evaluation
+    pairsDirty = true;
+    pairsCost = -1;
+    kernelDirty = true;
 
     while (nbFireTot == k && k <= nMax) {
       k++;
@@ -129,25 +195,456 @@ public:
     }
     
     if (k == nMin)
-      return x.fitness(0);
+      x.fitness(0);
     else
-      return x.fitness(k - 1);
+      x.fitness(k - 1);
+
+    FSSP_COUNT(countFailure(x.fitness(), nMax);)
+
+    if (cache != NULL && cache->nMax() == nMax)
+      cache->insert(x.hash(), x.fitness());
+  }
+
+  /*********************************************
+   * same as eval, and the first size where each rule is used
+   *
+   * The solution becomes the incumbent of the incremental evaluation
+   * (see initIncremental).
+   *
+   * output : firstUse : firstUse[i] is the first size which uses the rule i,
+   *                     0 when the rule is not used by the sizes 3 to fitness+1:
+   *                     a mutation of this rule does not modify the fitness
+   *
+   *********************************************/
+  void eval(Solution<NbStates> & x, int nMax, std::vector<int> & firstUse) {
+    FSSP_COUNT(evalCounters().evaluations++;)
+
+    initIncremental(x, nMax);
+
+    FSSP_COUNT(countFailure(x.fitness(), incrementalNMax);)
+
+    firstUse.assign(firstSize, firstSize + nbRules);
+  }
+
+  /*********************************************
+   * incremental evaluation: set the incumbent solution
+   *
+   * Same as eval, but records for each rule the first size
+   * (and time step) where the rule is used, and keeps a copy
+   * of the part of the space-time diagram computed for each size.
+   * Then evalIncremental can evaluate a single rule mutation
+   * of the incumbent from the first size where this rule is used.
+   *
+   * input : x : incumbent solution
+   *         nMax : maximum size of the firing squad
+   *
+   *********************************************/
+  void initIncremental(Solution<NbStates> & x, int nMax) {
+    int nMin = 2;
+
+    if (nMax > maxSize - 1)
+      nMax = maxSize - 1;
+
+    for(int i = 0; i < nbRules; i++)
+      firstSize[i] = 0;
+
+    loadTrace(x.rules, nMin);
+
+    x.fitness(runIncremental(x.rules, nMax, nMin + 1, 0, true));
+
+    incrementalNMax = nMax;
+    incrementalFitness = x.fitness();
+  }
+
+  /*********************************************
+   * incremental evaluation of a single rule mutation
+   *
+   *   IMPORTANT:
+   *   x is the incumbent given to initIncremental (or commitIncremental)
+   *   with only the rule x.rules[index] modified
+   *
+   * When the rule is not used before the size which breaks the incumbent,
+   * the fitness is the one of the incumbent without any computation.
+   * Otherwise, the computation starts from the first size (and time step) 
+   * where the rule is used with the diagram of the incumbent.
+   *
+   * input : x : mutated solution
+   *         nMax : maximum size of the firing squad
+   *         index : index of the modified rule
+   *
+   *********************************************/
+  void evalIncremental(Solution<NbStates> & x, int nMax, int index) {
+    if (nMax > maxSize - 1)
+      nMax = maxSize - 1;
+
+    if (nMax != incrementalNMax) {
+      eval(x, nMax);
+      return;
+    }
+
+    FSSP_COUNT(evalCounters().evaluations++;)
+    nbEvaluations++;
+
+    int k = firstSize[index];
+
+    // rule not used until the size which breaks the incumbent: same fitness
+    if (k == 0) {
+      x.fitness(incrementalFitness);
+      return;
+    }
+
+    int f;
+    if (cache != NULL && cache->nMax() == nMax && cache->find(x.hash(), f)) {
+      x.fitness(f);
+      return;
+    }
+
+    restoreSnapshot(x.rules, k, firstTime[index]);
+
+    x.fitness(runIncremental(x.rules, nMax, k, firstTime[index], false));
+
+    FSSP_COUNT(countFailure(x.fitness(), nMax);)
+
+    if (cache != NULL && cache->nMax() == nMax)
+      cache->insert(x.hash(), x.fitness());
+  }
+
+  /*********************************************
+   * incremental evaluation: the mutated solution becomes the incumbent
+   *
+   * The fitness of x is set: there is no need to call evalIncremental before
+   * when the mutation is always accepted (but the evaluation is not counted).
+   *
+   * input : x : mutated solution
+   *         nMax : maximum size of the firing squad
+   *         index : index of the modified rule
+   *
+   *********************************************/
+  void commitIncremental(Solution<NbStates> & x, int nMax, int index) {
+    if (nMax > maxSize - 1)
+      nMax = maxSize - 1;
+
+    if (nMax != incrementalNMax) {
+      initIncremental(x, nMax);
+      return;
+    }
+
+    int k = firstSize[index];
+
+    // same space-time diagram than the incumbent
+    if (k == 0)
+      return;
+
+    int t = firstTime[index];
+
+    // forget the rules used after the mutation
+    for(int i = 0; i < nbRules; i++)
+      if (firstSize[i] > k || (firstSize[i] == k && firstTime[i] >= t))
+        firstSize[i] = 0;
+
+    restoreSnapshot(x.rules, k, t);
+
+    x.fitness(runIncremental(x.rules, nMax, k, t, true));
+
+    incrementalFitness = x.fitness();
+  }
+
+  /*********************************************
+   * verification of the synchronization of the size N
+   * with only two rows of the space-time diagram in memory:
+   * there is no constraint on N (no maximum size of the automata)
+   *
+   * input : x : solution
+   *         N : size of the firing squad
+   *
+   * output : true when all the cells fire at time 2N-2 (and not before)
+   *
+   *********************************************/
+  static bool verify(Solution<NbStates> & x, int N) {
+    uint64_t nbCells = 0;
+
+    return verify(x, N, nbCells);
+  }
+
+  /*********************************************
+   * same as verify, and count the computed cells
+   *
+   * output : nbCells : nbCells + number of computed cells
+   *
+   *********************************************/
+  static bool verify(Solution<NbStates> & x, int N, uint64_t & nbCells) {
+    std::vector<uint8_t> prev(N + 1);
+    std::vector<uint8_t> cur(N + 1);
+    std::vector<uint8_t> pairs(nbWindows);
+    RowKernel<NbStates> kernel;
+
+    buildPairs(pairs.data(), x.rules);
+    kernel.setRules(x.rules);
+
+    return evolStreaming(x.rules, pairs.data(), kernel, N, prev.data(), cur.data(), nbCells) == N;
+  }
+
+  /*********************************************
+   * verification of the sizes from nMin to nMax
+   * (same memory than the size nMax)
+   *
+   * input : x : solution
+   *         nMin : first size to verify
+   *         nMax : last size to verify
+   *
+   * output : synchronized : synchronized[n - nMin] is true when the size n synchronizes
+   *          return the last size n such that all the sizes from nMin to n synchronize
+   *          (nMin - 1 when the size nMin does not)
+   *
+   *********************************************/
+  static int verify(Solution<NbStates> & x, int nMin, int nMax, std::vector<bool> & synchronized) {
+    uint64_t nbCells = 0;
+    std::vector<uint8_t> prev(nMax + 1);
+    std::vector<uint8_t> cur(nMax + 1);
+    std::vector<uint8_t> pairs(nbWindows);
+    RowKernel<NbStates> kernel;
+
+    buildPairs(pairs.data(), x.rules);
+    kernel.setRules(x.rules);
+
+    int last = nMin - 1;
+
+    synchronized.resize(nMax - nMin + 1);
+
+    for(int n = nMin; n <= nMax; n++) {
+      synchronized[n - nMin] = (evolStreaming(x.rules, pairs.data(), kernel, n, prev.data(), cur.data(), nbCells) == n);
+
+      if (synchronized[n - nMin] && last == n - 1)
+        last = n;
+    }
+
+    return last;
+  }
+
+  /*********************************************
+   * evaluation of all the neighbors of a solution:
+   * each useful rule (x.indices) is set to each non-firing state
+   *
+   * The rules are shared between the threads of a pool,
+   * each thread uses its own automata (incremental evaluation).
+   *
+   * input : x : solution
+   *         nMax : maximum size of the firing squad
+   *
+   * output : out : fitness of the neighbors,
+   *                out[j * FIRE + v] : rule x.indices[j] set to v
+   *                (fitness of x when v is the current value)
+   *
+   *********************************************/
+  void evalNeighborhood(const Solution<NbStates> & x, int nMax, std::vector<int> & out) {
+    auto none = [](int, const Solution<NbStates> &, int, int) { };
+
+    evalNeighborhood(x, nMax, out, none);
+  }
+
+  /*********************************************
+   * same as evalNeighborhood, and each neighbor is given to f
+   * by the thread which evaluates it
+   *
+   * input : f : function called by f(thread, y, j, v) for each neighbor y
+   *             (rule x.indices[j] set to v, fitness computed),
+   *             y is only valid during the call
+   *
+   *********************************************/
+  template <class F>
+  void evalNeighborhood(const Solution<NbStates> & x, int nMax, std::vector<int> & out, F & f) {
+    if (pool == NULL)
+      createWorkspaces();
+
+    out.resize(x.indices.size() * FIRE);
+
+    for(unsigned i = 0; i < workReady.size(); i++)
+      workReady[i] = false;
+
+    auto task = [&](int thread, int j) {
+      Automata & ca = *workspaces[thread];
+      Solution<NbStates> & s = *workSolutions[thread];
+
+      if (!workReady[thread]) {
+        s = x;
+        ca.initIncremental(s, nMax);
+        workReady[thread] = true;
+      }
+
+      int index = x.indices[j];
+      int value = s.rules[index];
+
+      for(int v = 0; v < FIRE; v++) {
+        if (v == value)
+          out[j * FIRE + v] = ca.incrementalFitness;
+        else {
+          s.setRule(index, v);
+          ca.evalIncremental(s, nMax, index);
+          out[j * FIRE + v] = s.fitness();
+          f(thread, s, j, v);
+        }
+      }
+
+      s.setRule(index, value);
+    };
+
+    pool->run(x.indices.size(), task);
+  }
+
+  /*********************************************
+   * number of cells computed by the automata (eval, incremental evaluation)
+   * since the construction or the last reset
+   *
+   *********************************************/
+  uint64_t cellUpdates() const {
+    uint64_t n = nbCellUpdates;
+    for(unsigned i = 0; i < workspaces.size(); i++)
+      n += workspaces[i]->cellUpdates();
+    return n;
+  }
+
+  void resetCellUpdates() {
+    nbCellUpdates = 0;
+    for(unsigned i = 0; i < workspaces.size(); i++)
+      workspaces[i]->resetCellUpdates();
+  }
+
+  /*********************************************
+   * number of evaluated solutions (eval, evalIncremental) by the automata
+   * and the automata of its threads, since the construction or the last reset:
+   * the mutations rejected without evaluation are not counted
+   *
+   *********************************************/
+  uint64_t evaluations() const {
+    uint64_t n = nbEvaluations;
+    for(unsigned i = 0; i < workspaces.size(); i++)
+      n += workspaces[i]->evaluations();
+    return n;
+  }
+
+  void resetEvaluations() {
+    nbEvaluations = 0;
+    for(unsigned i = 0; i < workspaces.size(); i++)
+      workspaces[i]->resetEvaluations();
+  }
+
+  /*********************************************
+   * stop of the searches (random walk, hill climber, iterated local search)
+   * before their number of iterations:
+   * f(x) is called with the current solution x (evaluated) every stopPeriod iterations
+   * of the random walk and of the hill climber, and after each hill climber
+   * of the iterated local search; the search stops when f returns true
+   *
+   * input : f : stop function, nullptr: no stop
+   *
+   *********************************************/
+  void setStop(std::function<bool(const Solution<NbStates> &)> f) {
+    stopFunction = f;
+  }
+
+  /*********************************************
+   * parameters of the iterated local search (default 10 and 10000)
+   *
+   * input : strength : number of rules modified by the perturbation
+   *         hillClimberIter : number of iterations of each hill climber
+   *
+   *********************************************/
+  void setIteratedLocalSearch(int strength, int hillClimberIter) {
+    ilsStrength = strength;
+    ilsHillClimberIter = hillClimberIter;
+  }
+
+  /*********************************************
+   * cache of the fitness values used by eval and evalIncremental
+   * when nMax is the one of the cache (NULL: no cache)
+   *
+   * The cache can be shared by several automata (threads),
+   * the solutions have to keep their hash (see Solution::setRule)
+   *
+   *********************************************/
+  void setCache(FitnessCache * _cache) {
+    cache = _cache;
+
+    for(unsigned i = 0; i < workspaces.size(); i++)
+      workspaces[i]->setCache(cache);
+  }
+
+  /*********************************************
+   * mutations of the hill climber only on the rules used by the incumbent
+   * (until the size which breaks it, see eval with firstUse):
+   * the mutations of the other rules are redrawn (see redrawnMutations)
+   *
+   * The option changes the trajectory, not the cost of the evaluations:
+   * a mutation of an unused rule is already evaluated without simulation
+   * (same fitness, see evalIncremental), and it is accepted as a neutral move.
+   * With the option, the unused rules keep their values,
+   * and each iteration of the hill climber mutates a used rule.
+   *
+   *********************************************/
+  void setUsedRulesOnly(bool _usedRulesOnly) {
+    usedRulesOnly = _usedRulesOnly;
+  }
+
+  /*********************************************
+   * number of mutations of unused rules redrawn by the hill climber
+   * (see setUsedRulesOnly) since the construction or the last reset
+   *
+   *********************************************/
+  uint64_t redrawnMutations() const {
+    return nbRedrawnMutations;
+  }
+
+  void resetRedrawnMutations() {
+    nbRedrawnMutations = 0;
+  }
+
+  /*********************************************
+   * speculative hill climber: nbMoves mutations are drawn
+   * and evaluated in parallel by the threads of evalNeighborhood,
+   * the first accepted one in the order of the draws is applied,
+   * so the trajectory is the one of the sequential hill climber
+   * (1: sequential hill climber)
+   *
+   *********************************************/
+  void setSpeculation(int nbMoves) {
+    speculation = (nbMoves < 1) ? 1 : nbMoves;
+  }
+
+  /*********************************************
+   * number of threads of evalNeighborhood (0: number of cores)
+   *
+   *********************************************/
+  void setNbThreads(int _nbThreads) {
+    deleteWorkspaces();
+    nbThreads = _nbThreads;
   }
   
 
   
-  void marcheAleatoire(Solution & x, int nMax, int maxIter){ 
-	  eval(x, nMax);
-	  int best = x.fitness();
-	  vector<int> v(x.indices);
-	  Solution temp(x); 
-	  eval(temp, maxSize);
+  /*********************************************
+   * random walk: each mutation is applied in place and committed,
+   * x is the best solution of the walk at the end
+   *
+   *********************************************/
+  void marcheAleatoire(Solution<NbStates> & x, int nMax, int maxIter){ 
+	  marcheAleatoire(x, nMax, maxIter, Random::local());
+  }
+
+  void marcheAleatoire(Solution<NbStates> & x, int nMax, int maxIter, Random & rng){ 
+	  initIncremental(x, nMax);
+	  // best solution of the walk (fitness of nMax, as the walk)
+	  Solution<NbStates> temp(x); 
 	  int randomIndice = 0, randomValue = 0;
 	  for(int i = 0; i < maxIter; i++){
-		randomIndice = rand() % v.size();
-		randomValue = rand() % FIRE;
-		x.rules[v.at(randomIndice)] = randomValue;
-		eval(x, nMax);
+		if (stopFunction && i % stopPeriod == 0 && stopFunction(x))
+			break;
+		randomIndice = x.indices[rng(x.indices.size())];
+		randomValue = rng(FIRE);
+		x.setRule(randomIndice, randomValue);
+		// the mutation is always accepted: a single simulation from the first size using the rule
+		FSSP_COUNT(evalCounters().evaluations++;)
+		nbEvaluations++;
+		commitIncremental(x, nMax, randomIndice);
 	
 		if(x.fitness() > temp.fitness()){
 			temp = x; }
@@ -158,71 +655,340 @@ public:
 
 	
 	
-	void hillClimberFirst(Solution & solution,int nMax,int maxIter){
-		srand(time(NULL));	
-		eval(solution,nMax);
+	void hillClimberFirst(Solution<NbStates> & solution,int nMax,int maxIter){
+		hillClimberFirst(solution, nMax, maxIter, Random::local());
+	}
+	
+	/*********************************************
+	 * first improvement hill climber (the moves of equal fitness are accepted)
+	 *
+	 * The mutation is applied in place on the solution, and undone
+	 * when it is rejected: no copy of the solution by iteration.
+	 *
+	 *********************************************/
+	void hillClimberFirst(Solution<NbStates> & solution,int nMax,int maxIter,Random & rng){
+		if (speculation > 1) {
+			hillClimberSpeculative(solution, nMax, maxIter, rng);
+			return;
+		}
+		
+		initIncremental(solution,nMax);
 			
-		//Solution s (5);
-		Solution s = solution;
-		//srand(time(NULL));	
-		//int * tmpRule = x.rules;
-		//eval(solution, nMax);
-		int fitness ;//= solution.fitness();
-		int fitNN = 0;
-		int nextIndice = 0, nextVal = 0;		
+		int fitness, index, value, nextVal;
+		uint64_t redrawn = 0;
 		for(int i = 0; i < maxIter; i++){
-			s= solution;
-			//std::vector< std::pair< int,int > > worse;
-			nextIndice = rand() % solution.indices.size();
-			nextVal = /*rand() % 4;*/( s.rules[solution.indices.at(nextIndice)] + (rand() % (3-1) +1))% 4;
-			/*do{
-				 nextVal = rand()%FIRE ;
-				 
-			 }while(nextVal == s.rules[solution.indices.at(nextIndice)]);
-		*/
-			s.rules[solution.indices.at(nextIndice)] = nextVal;
-			//std::cout<<" oui : " << nextVal << std::endl;
-			eval(s,nMax);
-			//cout << "S:" << s << endl;
-			//cout << "X:" << solution << endl;
-			//fitNN = s.fitness();
-			if(s.fitness()>= solution.fitness()){ //first improve
-				//cout << "S:" << s << endl;
-				//cout << fitNN;
-				solution= s;
-				if(s.fitness()> solution.fitness()){cout << solution ;}
-				//solution.rules[solution.indices[nextIndice]] = nextVal;
-				//x.rules = s.rules;
-				//std ::cout << "fitnessNN " << fitNN ;
-				//x.fitness(s.fitness());
-				//x = s ;
-			}	
+			if (stopFunction && i % stopPeriod == 0 && stopFunction(solution))
+				break;
+			index = solution.indices.at(rng(solution.indices.size()));
+			// rule not used by the incumbent: neutral mutation, redrawn
+			while (usedRulesOnly && firstSize[index] == 0) {
+				redrawn++;
+				index = solution.indices.at(rng(solution.indices.size()));
+			}
+			value = solution.rules[index];
+			nextVal = ( value + (rng(3-1) +1))% FIRE;
+			fitness = solution.fitness();
+			
+			solution.setRule(index, nextVal);
+			evalIncremental(solution,nMax,index);
+			
+			if(solution.fitness()>= fitness){ //first improve
+				commitIncremental(solution,nMax,index);
+			} else {
+				solution.setRule(index, value);
+				solution.fitness(fitness);
+			}
 		}
+		nbRedrawnMutations += redrawn;
 	}
 	
 	
-	void iteratedLocalSearch(Solution & solution,int nMax,int maxIter){
-		srand(time(NULL));
-		int randIndice, randVal;
+	/*********************************************
+	 * speculative first improvement hill climber (see setSpeculation)
+	 *
+	 * The mutations are drawn by blocks of speculation moves from the incumbent,
+	 * and evaluated in parallel, each thread with its own incumbent (see syncWorkspace).
+	 * The moves before the first accepted one are also rejected by hillClimberFirst;
+	 * the moves after it are drawn again from the new incumbent:
+	 * the generator is restored, and the draws until the accepted move are replayed.
+	 *
+	 *********************************************/
+	void hillClimberSpeculative(Solution<NbStates> & solution,int nMax,int maxIter,Random & rng){
+		if (pool == NULL)
+			createWorkspaces();
+		
+		initIncremental(solution,nMax);
+		
+		acceptedMoves.clear();
+		for(unsigned i = 0; i < workReady.size(); i++)
+			workReady[i] = false;
+		
+		std::vector<int> moveIndex(speculation), moveValue(speculation), moveFitness(speculation);
+		uint64_t redrawn = 0;
+		
+		// draw of the move m (same draws as hillClimberFirst)
+		auto draw = [&](int m) {
+			int index = solution.indices.at(rng(solution.indices.size()));
+			// rule not used by the incumbent: neutral mutation, redrawn
+			while (usedRulesOnly && firstSize[index] == 0) {
+				redrawn++;
+				index = solution.indices.at(rng(solution.indices.size()));
+			}
+			moveIndex[m] = index;
+			moveValue[m] = (solution.rules[index] + (rng(3-1) + 1)) % FIRE;
+		};
+		
+		auto task = [&](int thread, int m) {
+			Automata & ca = *workspaces[thread];
+			Solution<NbStates> & s = *workSolutions[thread];
+			
+			syncWorkspace(thread, solution, nMax);
+			
+			int index = moveIndex[m];
+			int value = s.rules[index];
+			
+			s.setRule(index, moveValue[m]);
+			ca.evalIncremental(s, nMax, index);
+			moveFitness[m] = s.fitness();
+			
+			s.setRule(index, value);
+			s.fitness(ca.incrementalFitness);
+		};
+		
+		int i = 0, nextStop = 0;
+		while (i < maxIter) {
+			if (stopFunction && i >= nextStop) {
+				if (stopFunction(solution))
+					break;
+				nextStop = i + stopPeriod;
+			}
+			int nbMoves = std::min(speculation, maxIter - i);
+			Random start(rng);
+			uint64_t redrawnStart = redrawn;
+			
+			for(int m = 0; m < nbMoves; m++)
+				draw(m);
+			
+			pool->run(nbMoves, task);
+			
+			int first = 0;
+			while (first < nbMoves && moveFitness[first] < solution.fitness())
+				first++;
+			
+			if (first == nbMoves) {
+				i += nbMoves;
+				continue;
+			}
+			
+			// the moves after the accepted one are drawn again
+			rng = start;
+			redrawn = redrawnStart;
+			for(int m = 0; m <= first; m++)
+				draw(m);
+			
+			solution.setRule(moveIndex[first], moveValue[first]);
+			solution.fitness(moveFitness[first]);
+			acceptedMoves.push_back(std::make_pair(moveIndex[first], moveValue[first]));
+			
+			// the draws read the rules used by the incumbent
+			if (usedRulesOnly)
+				commitIncremental(solution, nMax, moveIndex[first]);
+			
+			i += first + 1;
+		}
+		
+		// the solution is the incumbent of the incremental evaluation, as with hillClimberFirst
+		if (!usedRulesOnly && !acceptedMoves.empty())
+			initIncremental(solution, nMax);
+		
+		nbRedrawnMutations += redrawn;
+	}
+	
+	void iteratedLocalSearch(Solution<NbStates> & solution,int nMax,int maxIter){
+		iteratedLocalSearch(solution, nMax, maxIter, Random::local());
+	}
+	
+	void iteratedLocalSearch(Solution<NbStates> & solution,int nMax,int maxIter,Random & rng){
 		//Solution s = solution;
 		for(int i = 0; i < maxIter; i++){
-			hillClimberFirst(solution,nMax,10000);
+			hillClimberFirst(solution,nMax,ilsHillClimberIter,rng);
 						eval(solution,nMax);
+			if (stopFunction && stopFunction(solution))
+				break;
 
-			for(int i = 0; i < 10; i++){
-				randIndice = rand() % solution.indices.size();
-				randVal = /*rand() % 4;*/( solution.rules[solution.indices.at(randIndice)] + (rand() % (3-1) +1))% 4;
-				solution.rules[randIndice] = randVal;
-			}
+			perturbation(solution, ilsStrength, rng);
 			
-			hillClimberFirst(solution,nMax,10000);
+			hillClimberFirst(solution,nMax,ilsHillClimberIter,rng);
 						eval(solution,nMax);
+			if (stopFunction && stopFunction(solution))
+				break;
 
 			
 		}
 		
 	}
 	
+	/*********************************************
+	 * iterated local search with checkpoints
+	 *
+	 * When the checkpoint file exists (same nMax, maxIter and initial solution)
+	 * and the search of the checkpoint is not completed, the search
+	 * restarts from it: same solutions, iterations and random generator.
+	 * Otherwise a new search starts, and overwrites the checkpoint.
+	 * A checkpoint is written at the end of the first iteration after each period
+	 * of time, and at the end.
+	 * On SIGINT or SIGTERM, the search writes the checkpoint and stops
+	 * at the end of the current iteration (also when the stop function returns true, see setStop).
+	 *
+	 * input : solution : initial solution (not used when the search restarts)
+	 *         nMax : maximum size of the firing squad
+	 *         maxIter : number of iterations
+	 *         rng : random generator
+	 *         fileName : checkpoint file
+	 *         period : time between two checkpoints (seconds)
+	 *
+	 * output : solution : best solution
+	 *          return true when all the iterations are done
+	 *
+	 *********************************************/
+	bool iteratedLocalSearch(Solution<NbStates> & solution,int nMax,int maxIter,Random & rng,const char * fileName,double period){
+		Checkpoint<NbStates> checkpoint;
+		
+		if (checkpoint.load(fileName) && checkpoint.nMax == nMax && checkpoint.maxIter == maxIter && checkpoint.initial == solution.hash()
+		    && checkpoint.iteration < (uint64_t) maxIter && rng.setState(checkpoint.randomState)) {
+			std::cerr << "iteratedLocalSearch: restart from " << fileName << " at iteration " << checkpoint.iteration << std::endl;
+		} else {
+			checkpoint.nMax = nMax;
+			checkpoint.maxIter = maxIter;
+			checkpoint.iteration = 0;
+			checkpoint.initial = solution.hash();
+			checkpoint.current = solution;
+			checkpoint.best = solution;
+			eval(checkpoint.best, nMax);
+		}
+		
+		Solution<NbStates> & current = checkpoint.current;
+		Solution<NbStates> & best = checkpoint.best;
+		
+		Checkpoint<NbStates>::clearStop();
+		Checkpoint<NbStates>::catchSignals(true);
+		
+		std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+		
+		while (checkpoint.iteration < (uint64_t) maxIter && !Checkpoint<NbStates>::stopRequested()) {
+			hillClimberFirst(current,nMax,ilsHillClimberIter,rng);
+			eval(current,nMax);
+			if (current.fitness() > best.fitness())
+				best = current;
+			
+			perturbation(current, ilsStrength, rng);
+			
+			hillClimberFirst(current,nMax,ilsHillClimberIter,rng);
+			eval(current,nMax);
+			if (current.fitness() > best.fitness())
+				best = current;
+			
+			checkpoint.iteration++;
+			if (std::chrono::duration<double>(std::chrono::steady_clock::now() - last).count() >= period && checkpoint.iteration < (uint64_t) maxIter) {
+				checkpoint.randomState = rng.state();
+				checkpoint.save(fileName);
+				last = std::chrono::steady_clock::now();
+			}
+			
+			// stop function (see setStop): as a signal, the checkpoint is written
+			if (stopFunction && stopFunction(current))
+				break;
+		}
+		
+		checkpoint.randomState = rng.state();
+		checkpoint.save(fileName);
+		
+		Checkpoint<NbStates>::catchSignals(false);
+		
+		solution = best;
+		
+		return checkpoint.iteration == (uint64_t) maxIter;
+	}
+	
+	/*********************************************
+	 * perturbation of the iterated local search:
+	 * modification of random useful rules
+	 *
+	 * input : solution : solution to perturb
+	 *         strength : number of modified rules
+	 *         rng : random generator
+	 *
+	 *********************************************/
+	void perturbation(Solution<NbStates> & solution,int strength,Random & rng){
+		int randIndice, randVal;
+		for(int i = 0; i < strength; i++){
+			randIndice = rng(solution.indices.size());
+			randVal = ( solution.rules[solution.indices.at(randIndice)] + (rng(3-1) +1))% FIRE;
+			solution.setRule(solution.indices.at(randIndice), randVal);
+		}
+		solution.invalidate();
+	}
+	
+	/*********************************************
+	 * island model of the iterated local search
+	 *
+	 * Each island runs the iterated local search in its own thread
+	 * with its own automata and random generator.
+	 * Every migration iterations, each island publishes its best solution,
+	 * and takes the solution published by the previous island (ring)
+	 * when it is better than its current solution.
+	 * The exchange of solutions is lock-free (atomic pointers).
+	 * The islands use the settings of this automata (cache, speculation, used rules only,
+	 * iterated local search, stop function); the stop function is called by one island
+	 * at a time, and all the islands stop when it returns true.
+	 *
+	 * input : solution : initial solution, and the best solution at the end
+	 *         nMax : maximum size of the firing squad
+	 *         maxIter : number of iterations of each island
+	 *         nbIslands : number of islands (threads), 0 for the number of cores
+	 *         migration : number of iterations between two migrations (0 or less: no migration)
+	 *         seed : seed of the random generators (one stream of the seed by island)
+	 *
+	 *********************************************/
+	void islandIteratedLocalSearch(Solution<NbStates> & solution,int nMax,int maxIter,int nbIslands,int migration,unsigned seed){
+		if (nbIslands <= 0)
+			nbIslands = std::thread::hardware_concurrency();
+		if (nbIslands <= 0)
+			nbIslands = 1;
+		
+		// published best solution of each island
+		std::vector< std::atomic<Solution<NbStates>*> > published(nbIslands);
+		for(int i = 0; i < nbIslands; i++)
+			published[i] = NULL;
+		
+		std::vector<Solution<NbStates>*> best(nbIslands);
+		std::vector<std::thread> threads;
+		
+		// stop function shared by the islands
+		std::mutex stopMutex;
+		std::atomic<bool> stopped(false);
+		
+		for(int i = 0; i < nbIslands; i++) {
+			best[i] = new Solution<NbStates>(solution);
+			threads.push_back(std::thread(&Automata::island, this, i, nbIslands, std::ref(solution), best[i], nMax, maxIter, migration, seed, published.data(), &stopMutex, &stopped));
+		}
+		
+		for(int i = 0; i < nbIslands; i++)
+			threads[i].join();
+		
+		int b = 0;
+		for(int i = 1; i < nbIslands; i++)
+			if (best[i]->fitness() > best[b]->fitness())
+				b = i;
+		solution = *best[b];
+		
+		for(int i = 0; i < nbIslands; i++) {
+			delete best[i];
+			if (published[i] != NULL)
+				delete published[i].load();
+		}
+	}
+	
 
 		
 			
@@ -237,15 +1003,110 @@ public:
    *.   x : solution
    *.   N : size of the firing squad (number of cells)
    *.   all : true: from 2 to N; false: only N
+   *.   blackFire : true: FIRE is black (black and white printing), false: FIRE is red
+   *
+   *********************************************/
+  void exportSVG(Solution<NbStates> & x, int N, const char * fileName, bool all = false, bool blackFire = false) {
+    print(x.rules, N, fileName, all, blackFire);
+  }
+
+  /*********************************************
+   * export in a raster image: binary PPM, or PNG when the name ends with .png
+   * (same drawing than exportSVG, without the lines between the cells)
+   *
+   * The rows are computed and written one by one: only two rows by size
+   * are in memory, and N is not limited by the maximum size of the automata.
+   *
+   * input :
+   *.   x : solution
+   *.   N : size of the firing squad (number of cells)
+   *.   all : true: from 2 to N; false: only N
+   *.   scale : size of a cell (scale x scale pixels)
+   *
+   *********************************************/
+  static void exportRaster(Solution<NbStates> & x, int N, const char * fileName, bool all = false, int scale = 1) {
+    int nInit = all ? 2 : N;
+
+    // size of the image (cells)
+    int w = all ? (N * (N + 1) / 2 + (N - 1) * 2) : (N + 1);
+    int h = 2 * N;
+
+    uint8_t palette[3 * (IMPOSSIBLE + 1)];
+    for(int state = 0; state <= IMPOSSIBLE; state++)
+      colorRaster(state, palette + 3 * state);
+
+    RasterWriter image(fileName, w * scale, h * scale, palette, IMPOSSIBLE + 1);
+    if (!image.isOpen())
+      return;
+
+    // two rows by size, and the first column of the size in the image
+    int nbSizes = N - nInit + 1;
+    std::vector<size_t> offset(nbSizes);
+    std::vector<int> column(nbSizes);
+    std::vector<bool> drawing(nbSizes, true);
+    size_t length = 0;
+    int c = 1;
+    for(int k = 0; k < nbSizes; k++) {
+      int n = nInit + k;
+      offset[k] = length;
+      length += 2 * n;
+      column[k] = c;
+      c += n + 2;
+    }
+
+    std::vector<uint8_t> rows(length, REPOS);
+    std::vector<uint8_t> pixels(w * scale, REPOS);
+
+    // time 0 is the second row of the image
+    for(int i = -1; i < h - 1; i++) {
+      std::fill(pixels.begin(), pixels.end(), REPOS);
+
+      for(int k = 0; k < nbSizes && i >= 0; k++) {
+        if (!drawing[k])
+          continue;
+
+        int n = nInit + k;
+        uint8_t * prev = rows.data() + offset[k] + (i & 1) * n;
+        uint8_t * cur  = rows.data() + offset[k] + ((i + 1) & 1) * n;
+        int nbFire;
+
+        if (i == 0) {
+          cur[0] = GEN;
+          nbFire = 0;
+        } else
+          nbFire = stepWithUnused(x.rules, n, i, prev, cur);
+
+        for(int j = 0; j < n; j++) {
+          uint8_t state = (cur[j] <= IMPOSSIBLE) ? cur[j] : UNUSED;
+          memset(pixels.data() + (column[k] + j) * scale, state, scale);
+        }
+
+        // drawing until the row of the first fire, or time 2n-2
+        if (nbFire > 0 || i == 2 * n - 2)
+          drawing[k] = false;
+      }
+
+      for(int s = 0; s < scale; s++)
+        image.writeRow(pixels.data());
+    }
+
+    image.close();
+  }
+
+  /*********************************************
+   * size of the cells in the svg files (default: 10 x 10)
    *
    *********************************************/
-  void exportSVG(Solution & x, int N, const char * fileName, bool all = false) {
-    print(x.rules, N, fileName, all);
+  void setCellSize(int _width, int _height) {
+    width  = _width;
+    height = _height;
   }
 
 private:
-  // space-time diagram
-  int ** configs;
+  // space-time diagram: one contiguous buffer of rows,
+  // the row t only stores the cells 0 to t+1 (the next cells are REPOS),
+  // see row(t)
+  uint8_t * configs;
   
   // maximum size of the cellular automata
   int maxSize;
@@ -256,11 +1117,242 @@ private:
   // trace : left diagonal used in evolQuick
   int * trace;
   
+  // incremental evaluation:
+  // first size (0 when unused) and first time step where each rule is used by the incumbent
+  int * firstSize;
+  int * firstTime;
+  
+  // part of the space-time diagram computed by evolQuick for each size of the incumbent
+  // (allocated until the size which breaks the incumbent, see allocateSnapshots)
+  uint8_t * snapshots;
+  size_t * snapshotOffset;
+  int snapshotMaxSize;
+  
+  // nMax and fitness of the incumbent (incrementalNMax = -1 : no incumbent)
+  int incrementalNMax;
+  int incrementalFitness;
+  
+  // two cells by lookup: pairs[window(a, b, c, d)] is the pair of new cells
+  // of the centers b and c (see setPair), built from the rules pairRules
+  static const int nbWindows = 1 << (4 * 3);
+  uint8_t pairs[nbWindows];
+  uint8_t pairRules[nbRules];
+  bool pairsBuilt;
+  // true when the rules may differ from pairRules (new evaluation),
+  // and cost of the update (-1 : not computed, see updatePairsCost)
+  bool pairsDirty;
+  int pairsCost;
+
+  // below this size, the update of the pairs costs more than the lookups saved
+  static const int pairsMinSize = 12;
+
+  // vectorized update of the centre cells (see RowKernel), built from the rules of the evaluation,
+  // used for the rows with at least kernelMinCells centre cells
+  RowKernel<NbStates> kernel;
+  bool kernelDirty;
+  static const int kernelMinCells = 32;
+
+  // parallel evaluation of the neighborhood: pool of threads, and one automata by thread
+  ThreadPool * pool;
+  int nbThreads;
+  std::vector<Automata*> workspaces;
+  std::vector<Solution<NbStates>*> workSolutions;
+  std::vector<char> workReady;
+  
+  // cache of the fitness values (not owned)
+  FitnessCache * cache;
+  
+  // number of computed cells (see cellUpdates), and of evaluated solutions (see evaluations)
+  uint64_t nbCellUpdates;
+  uint64_t nbEvaluations;
+  
+  // stop of the searches (see setStop), called every stopPeriod iterations
+  std::function<bool(const Solution<NbStates> &)> stopFunction;
+  static const int stopPeriod = 1024;
+  
+  // perturbation and length of the hill climbers of the iterated local search (see setIteratedLocalSearch)
+  int ilsStrength;
+  int ilsHillClimberIter;
+  
+  // mutations of the hill climber (see setUsedRulesOnly)
+  bool usedRulesOnly;
+  std::atomic<uint64_t> nbRedrawnMutations;
+  
+  // mutations evaluated in parallel by the hill climber (see setSpeculation)
+  int speculation;
+  
+  // mutations applied to the incumbent of the speculative hill climber,
+  // and number of them applied to the incumbent of each thread
+  std::vector< std::pair<int, int> > acceptedMoves;
+  std::vector<size_t> workMoves;
+  
+  // above this number of mutations to apply, the incumbent of a thread is evaluated again
+  static const size_t maxWorkMoves = 4;
+
+  /*********************************************
+   * the incumbent of a thread becomes the one of the speculative hill climber:
+   * the accepted mutations are committed one by one (see commitIncremental)
+   *
+   *********************************************/
+  void syncWorkspace(int thread, const Solution<NbStates> & x, int nMax) {
+    Automata & ca = *workspaces[thread];
+    Solution<NbStates> & s = *workSolutions[thread];
+
+    if (!workReady[thread] || acceptedMoves.size() - workMoves[thread] > maxWorkMoves) {
+      s = x;
+      ca.initIncremental(s, nMax);
+      workReady[thread] = true;
+      workMoves[thread] = acceptedMoves.size();
+      return;
+    }
+
+    for(; workMoves[thread] < acceptedMoves.size(); workMoves[thread]++) {
+      int index = acceptedMoves[workMoves[thread]].first;
+
+      s.setRule(index, acceptedMoves[workMoves[thread]].second);
+      ca.commitIncremental(s, nMax, index);
+    }
+  }
+  
+  void createWorkspaces() {
+    pool = new ThreadPool(nbThreads);
+
+    for(int i = 0; i < pool->size(); i++) {
+      workspaces.push_back(new Automata(maxSize));
+      workspaces.back()->setCache(cache);
+      workSolutions.push_back(new Solution<NbStates>());
+      workReady.push_back(false);
+      workMoves.push_back(0);
+    }
+  }
+  
+  void deleteWorkspaces() {
+    if (pool != NULL)
+      delete pool;
+    pool = NULL;
+
+    for(unsigned i = 0; i < workspaces.size(); i++) {
+      delete workspaces[i];
+      delete workSolutions[i];
+    }
+    workspaces.clear();
+    workSolutions.clear();
+    workReady.clear();
+    workMoves.clear();
+  }
+  
   // for svg output
   int width ;
   int height;
   
   
+  /*********************************************
+   * one island of islandIteratedLocalSearch
+   *
+   * input : i : index of the island
+   *         nbIslands : number of islands
+   *         initial : initial solution (not modified)
+   *         best : best solution of the island
+   *         nMax, maxIter, migration : see islandIteratedLocalSearch
+   *         seed : seed of the random generators (the island uses the stream i)
+   *         published : published solutions of the islands
+   *         stopMutex, stopped : calls of the stop function, and true when it returned true
+   *
+   *********************************************/
+  void island(int i, int nbIslands, const Solution<NbStates> & initial, Solution<NbStates> * best, int nMax, int maxIter, int migration, unsigned seed, std::atomic<Solution<NbStates>*> * published,
+              std::mutex * stopMutex, std::atomic<bool> * stopped) {
+    Automata ca(maxSize);
+    ca.setCache(cache);
+    ca.setUsedRulesOnly(usedRulesOnly);
+    ca.setSpeculation(speculation);
+    ca.setIteratedLocalSearch(ilsStrength, ilsHillClimberIter);
+    if (stopFunction)
+      ca.setStop([this, stopMutex, stopped](const Solution<NbStates> & x) {
+        if (!*stopped) {
+          std::lock_guard<std::mutex> lock(*stopMutex);
+          if (!*stopped && stopFunction(x))
+            *stopped = true;
+        }
+        return stopped->load();
+      });
+    Random rng(seed, i);
+    Solution<NbStates> solution(initial);
+    Solution<NbStates> * other;
+
+    ca.eval(solution, nMax);
+    *best = solution;
+
+    for(int iter = 0; iter < maxIter; iter++) {
+      ca.hillClimberFirst(solution, nMax, ilsHillClimberIter, rng);
+      if (solution.fitness() > best->fitness())
+        *best = solution;
+      if (ca.stopFunction && ca.stopFunction(solution))
+        break;
+
+      ca.perturbation(solution, ilsStrength, rng);
+
+      ca.hillClimberFirst(solution, nMax, ilsHillClimberIter, rng);
+      if (solution.fitness() > best->fitness())
+        *best = solution;
+      if (ca.stopFunction && ca.stopFunction(solution))
+        break;
+
+      if (migration > 0 && (iter + 1) % migration == 0 && nbIslands > 1) {
+        // publish the best solution
+        other = published[i].exchange(new Solution<NbStates>(*best));
+        if (other != NULL)
+          delete other;
+
+        // immigration from the previous island
+        other = published[(i + nbIslands - 1) % nbIslands].exchange(NULL);
+        if (other != NULL) {
+          if (other->fitness() > solution.fitness())
+            solution = *other;
+          if (other->fitness() > best->fitness())
+            *best = *other;
+          delete other;
+        }
+      }
+    }
+
+    nbRedrawnMutations += ca.redrawnMutations();
+  }
+
+  /*********************************************
+   * storage of the space-time diagram
+   *
+   * The general is on the left, and the rules 000 -> 0 and 00B -> 0 are fixed:
+   * at time t, the cells after t stay REPOS.
+   * Then the row t only stores min(maxSize, t + 2) cells.
+   *
+   *********************************************/
+  size_t rowOffset(int t) {
+    if (t <= maxSize - 2)
+      return (size_t) t * (t + 3) / 2;
+    else
+      return (size_t) (maxSize - 2) * (maxSize + 1) / 2 + (size_t) (t - maxSize + 2) * maxSize;
+  }
+
+  int rowWidth(int t) {
+    if (t + 2 < maxSize)
+      return t + 2;
+    else
+      return maxSize;
+  }
+
+  // row t of the diagram
+  uint8_t * row(int t) {
+    return configs + rowOffset(t);
+  }
+
+  // cell i at time t of the diagram (REPOS outside the stored cells)
+  int cell(int t, int i) {
+    if (i < rowWidth(t))
+      return configs[rowOffset(t) + i];
+    else
+      return REPOS;
+  }
+
   /*********************************************
    * configurations initiale de l'automate
    *
@@ -268,12 +1360,10 @@ private:
    *********************************************/
   void initialConfigurations() {
     // repos
-    for(int i = 0; i < maxSize - 1; i++)
-      for(int j = 1 + i; j < maxSize; j++)
-        configs[i][j] = REPOS;
+    memset(configs, REPOS, rowOffset(maxIteration + 1));
     
     // general
-    configs[0][0] = GEN;
+    configs[0] = GEN;
   }
   
   
@@ -288,7 +1378,7 @@ private:
    * output : number of the firing after 2N-2 iteration
    *          0 else
    *********************************************/
-  int evol(int * regles, int N) {
+  int evol(const uint8_t * regles, int N) {
     int nbIter = 2 * N - 2;
     
     if (nbIter > maxIteration)
@@ -305,54 +1395,81 @@ private:
     
     int i, t;
     
+    // vectorized rows for the large sizes
+    bool useKernel = RowKernel<NbStates>::enabled() && N - 2 >= kernelMinCells;
+    if (useKernel) {
+      kernel.setRules(regles);
+      kernelDirty = true;
+    }
+    
     t = 1;
     
     // les premieres iterations en utilisant la propriete de quiescence 000 -> 0
     while (t < N - 1 && nbFire == 0) {
+      const uint8_t * prev = row(t - 1);
+      uint8_t * cur = row(t);
+      nbCellUpdates += t + 1;
+      FSSP_COUNT(evalCounters().cells += t + 1; evalCounters().lookups += t + 1;)
+
       // premiere cellule a gauche
-      r = regles[ BORD * nbDigits2 + configs[t-1][0] * nbDigits + configs[t-1][1] ];
+      r = regles[ BORD * nbDigits2 + prev[0] * nbDigits + prev[1] ];
       if (r == FIRE)
         nbFire++;
-      configs[t][0] = r;
+      cur[0] = r;
       
       // cellules du centre
-      for(i = 1; i < t; i++) {
-        r = regles[ configs[t-1][i-1] * nbDigits2 + configs[t-1][i] * nbDigits + configs[t-1][i+1] ];
+      i = 1;
+      if (useKernel && t - 1 >= kernelMinCells) {
+        nbFire += kernel.row(prev, cur, 1, t);
+        i = t;
+      }
+      for(; i < t; i++) {
+        r = regles[ prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1] ];
         if (r == FIRE)
           nbFire++;
-        configs[t][i] = r;
+        cur[i] = r;
       }
       
       // cellule a droite avant REPOS
-      r = regles[ configs[t-1][t - 1] * nbDigits2 + configs[t-1][t] * nbDigits + REPOS ];
+      r = regles[ prev[t - 1] * nbDigits2 + prev[t] * nbDigits + REPOS ];
       if (r == FIRE)
         nbFire++;
-      configs[t][t] = r;
+      cur[t] = r;
       
       t++;
     }
     
     // les iterations suivantes
     while (t <= nbIter && nbFire == 0) {
+      const uint8_t * prev = row(t - 1);
+      uint8_t * cur = row(t);
+      nbCellUpdates += N;
+      FSSP_COUNT(evalCounters().cells += N; evalCounters().lookups += N;)
+
       // premiere cellule a gauche
-      r = regles[ BORD * nbDigits2 + configs[t-1][0] * nbDigits + configs[t-1][1] ];
+      r = regles[ BORD * nbDigits2 + prev[0] * nbDigits + prev[1] ];
       if (r == FIRE)
         nbFire++;
-      configs[t][0] = r;
+      cur[0] = r;
       
       // cellules du centre
-      for(i = 1; i < N - 1; i++) {
-        r = regles[ configs[t-1][i-1] * nbDigits2 + configs[t-1][i] * nbDigits + configs[t-1][i+1] ];
+      i = 1;
+      if (useKernel) {
+        nbFire += kernel.row(prev, cur, 1, N - 1);
+        i = N - 1;
+      }
+      for(; i < N - 1; i++) {
+        r = regles[ prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1] ];
         if (r == FIRE)
           nbFire++;
-        configs[t][i] = r;
+        cur[i] = r;
       }
       
       // cellule a droite
-      r = regles[ configs[t-1][N - 2] * nbDigits2 + configs[t-1][N - 1] * nbDigits + BORD ];
+      r = regles[ prev[N - 2] * nbDigits2 + prev[N - 1] * nbDigits + BORD ];
       if (r == FIRE)
         nbFire++;
-      configs[t][N - 1] = r;
+      cur[N - 1] = r;
       
       t++;
     }
@@ -364,6 +1481,123 @@ private:
       return 0;
   }
   
+  /*********************************************
+   * evolution of the automate from initial configuration
+   * to the first time of firing (same as evol)
+   * with two rows of the diagram: the previous and the current one
+   *
+   * input : regles : rules of the automata
+   *         pairs : two cells by lookup of the rules (see buildPairs)
+   *         kernel : vectorized rows of the rules (see RowKernel)
+   *         N : size of the automata
+   *         prev, cur : rows of at least N + 1 cells
+   *
+   * output : number of the firing after 2N-2 iteration
+   *          0 else
+   *          nbCells : nbCells + number of computed cells
+   *********************************************/
+  static int evolStreaming(const uint8_t * regles, const uint8_t * pairs, const RowKernel<NbStates> & kernel, int N, uint8_t * prev, uint8_t * cur, uint64_t & nbCells) {
+    int nbIter = 2 * N - 2;
+    
+    // nombre d'etats feu
+    int nbFire = 0;
+    
+    // valeur de la regle locale
+    int r;
+    
+    int i, t, w;
+    uint8_t * tmp;
+
+    // configuration initiale
+    memset(prev, REPOS, N + 1);
+    memset(cur, REPOS, N + 1);
+    prev[0] = GEN;
+    
+    t = 1;
+    
+    // les premieres iterations en utilisant la propriete de quiescence 000 -> 0
+    while (t < N - 1 && nbFire == 0) {
+      nbCells += t + 1;
+      // premiere cellule a gauche
+      r = regles[ BORD * nbDigits2 + prev[0] * nbDigits + prev[1] ];
+      if (r == FIRE)
+        nbFire++;
+      cur[0] = r;
+      
+      // cellules du centre, vectorisees ou deux par deux
+      i = 1;
+      if (RowKernel<NbStates>::enabled() && t - 1 >= kernelMinCells) {
+        nbFire += kernel.row(prev, cur, 1, t);
+        i = t;
+      }
+      for(; i < t - 1; i += 2) {
+        w = pairs[ window(prev[i-1], prev[i], prev[i+1], prev[i+2]) ];
+        nbFire += pairFires(w);
+        cur[i]   = w & PAIR_CELL;
+        cur[i+1] = (w >> PAIR_BITS) & PAIR_CELL;
+      }
+      for(; i < t; i++) {
+        r = regles[ prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1] ];
+        if (r == FIRE)
+          nbFire++;
+        cur[i] = r;
+      }
+      
+      // cellule a droite avant REPOS
+      r = regles[ prev[t - 1] * nbDigits2 + prev[t] * nbDigits + REPOS ];
+      if (r == FIRE)
+        nbFire++;
+      cur[t] = r;
+      
+      tmp = prev; prev = cur; cur = tmp;
+      t++;
+    }
+    
+    // les iterations suivantes
+    while (t <= nbIter && nbFire == 0) {
+      nbCells += N;
+      // premiere cellule a gauche
+      r = regles[ BORD * nbDigits2 + prev[0] * nbDigits + prev[1] ];
+      if (r == FIRE)
+        nbFire++;
+      cur[0] = r;
+      
+      // cellules du centre, vectorisees ou deux par deux
+      i = 1;
+      if (RowKernel<NbStates>::enabled() && N - 2 >= kernelMinCells) {
+        nbFire += kernel.row(prev, cur, 1, N - 1);
+        i = N - 1;
+      }
+      for(; i < N - 2; i += 2) {
+        w = pairs[ window(prev[i-1], prev[i], prev[i+1], prev[i+2]) ];
+        nbFire += pairFires(w);
+        cur[i]   = w & PAIR_CELL;
+        cur[i+1] = (w >> PAIR_BITS) & PAIR_CELL;
+      }
+      for(; i < N - 1; i++) {
+        r = regles[ prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1] ];
+        if (r == FIRE)
+          nbFire++;
+        cur[i] = r;
+      }
+      
+      // cellule a droite
+      r = regles[ prev[N - 2] * nbDigits2 + prev[N - 1] * nbDigits + BORD ];
+      if (r == FIRE)
+        nbFire++;
+      cur[N - 1] = r;
+      
+      tmp = prev; prev = cur; cur = tmp;
+      t++;
+    }
+    
+    // nombre de fusiliers apres 2N-2 iterations
+    if (t == 2 * N - 2 + 1)
+      return nbFire;
+    else
+      return 0;
+  }
+
   /*********************************************
    * evolution of the automate from initial configuration
    * to the first time of firing.
@@ -379,7 +1613,24 @@ private:
    * output : number of the firing after 2N-2 iteration
    *          0 else
    *********************************************/
-  int evolQuick(int * regles, int N) {
+  int evolQuick(const uint8_t * regles, int N) {
+    return evolQuickFrom<false>(regles, N, 0);
+  }
+
+  /*********************************************
+   * same as evolQuick, but the computation can start
+   * at a time step tStart > N - 2 when the rows before tStart are already computed,
+   * and the first use of each rule can be recorded (incremental evaluation)
+   *
+   * input : regles : rules of the automata
+   *         N : size of the automata
+   *         tStart : first time step to compute
+   *
+   * output : number of the firing after 2N-2 iteration
+   *          0 else
+   *********************************************/
+  template <bool RECORD>
+  int evolQuickFrom(const uint8_t * regles, int N, int tStart) {
     int nbIter = 2 * N - 2;
     
     if (nbIter > maxIteration)
@@ -391,67 +1642,438 @@ private:
     // valeur de la regle locale
     int r;
     
-    int i, t;
+    int i, t, index, w;
+
+    FSSP_COUNT(EvalCounters & counters = evalCounters(); SizeTimer timer(N); int i0;)
+
+    // two cells by lookup for the large sizes (not when the use of the rules is recorded),
+    // when the update of the pairs costs less than the cells of the size N
+    if (!RECORD && N >= pairsMinSize && pairsDirty) {
+      if (pairsCost < 0)
+        pairsCost = updatePairsCost(regles);
+      if (pairsCost <= N * (N + 3) / 2) {
+        updatePairs(regles);
+        pairsDirty = false;
+      }
+    }
+    bool usePairs = !RECORD && N >= pairsMinSize && !pairsDirty;
+
+    // vectorized rows (not when the use of the rules is recorded)
+    bool useKernel = !RECORD && RowKernel<NbStates>::enabled() && N - 2 >= kernelMinCells;
+    if (useKernel && kernelDirty) {
+      kernel.setRules(regles);
+      kernelDirty = false;
+    }
     
-    // les premieres iterations en utilisant la propriete de quiescence 000 -> 0
-    // t = N - 2;
-    i = N - 2;
-    r = regles[ configs[N-3][i-1] * nbDigits2 + REPOS * nbDigits + REPOS ];
-    if (r == FIRE)
-      return 0;
-    configs[N-2][i] = r;
-    configs[N-2][N-1] = 0;
+    if (tStart <= N - 2) {
+      // les premieres iterations en utilisant la propriete de quiescence 000 -> 0
+      // t = N - 2;
+      i = N - 2;
+      index = row(N-3)[i-1] * nbDigits2 + REPOS * nbDigits + REPOS;
+      if (RECORD) recordUse(index, N, N - 2);
+      r = regles[ index ];
+      nbCellUpdates += 1;
+      FSSP_COUNT(counters.cells++; counters.lookups++;)
+      if (r == FIRE) {
+        FSSP_COUNT(counters.earlyFire++;)
+        return 0;
+      }
+      row(N-2)[i] = r;
+      row(N-2)[N-1] = 0;
+
+      t = N - 1;
+    } else
+      t = tStart;
 
     // les iterations suivantes jusqu'au bord gauche
-    t = N - 1;
     while (t < 2 * N - 4 && nbFire == 0) {
+      const uint8_t * prev = row(t - 1);
+      uint8_t * cur = row(t);
+      nbCellUpdates += t - N + 4;
+      FSSP_COUNT(counters.cells += t - N + 4; counters.lookups += t - N + 4;)
+
       // cellules du centre
-      for(i = 2 * N - 4 - t; i < N - 1; i++) {
-        r = regles[ configs[t-1][i-1] * nbDigits2 + configs[t-1][i] * nbDigits + configs[t-1][i+1] ];
-        if (r == FIRE)
+      i = 2 * N - 4 - t;
+      FSSP_COUNT(i0 = i;)
+      if (useKernel && N - 1 - i >= kernelMinCells) {
+        FSSP_COUNT(counters.lookups -= (N - 1 - i) - (N - 2 - i + RowKernel<NbStates>::width()) / RowKernel<NbStates>::width();)
+        if (kernel.row(prev, cur, i, N - 1) > 0) {
+          FSSP_COUNT(counters.earlyFire++;)
+          return 0;
+        }
+        i = N - 1;
+        FSSP_COUNT(i0 = i;)
+      }
+      if (usePairs) {
+        for(; i < N - 2; i += 2) {
+          w = pairs[ window(prev[i-1], prev[i], prev[i+1], prev[i+2]) ];
+          if (w & PAIR_FIRE) {
+            FSSP_COUNT(counters.earlyFire++;)
+            return 0;
+          }
+          cur[i]   = w & PAIR_CELL;
+          cur[i+1] = (w >> PAIR_BITS) & PAIR_CELL;
+        }
+        FSSP_COUNT(counters.lookups -= (i - i0) / 2;)
+      }
+      for(; i < N - 1; i++) {
+        index = prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1];
+        if (RECORD) recordUse(index, N, t);
+        r = regles[ index ];
+        if (r == FIRE) {
+          FSSP_COUNT(counters.earlyFire++;)
           return 0; //nbFire++;
-        configs[t][i] = r;
+        }
+        cur[i] = r;
       }
       
       // cellule a droite
-      r = regles[ configs[t-1][N - 2] * nbDigits2 + configs[t-1][N - 1] * nbDigits + BORD ];
-      if (r == FIRE)
+      index = prev[N - 2] * nbDigits2 + prev[N - 1] * nbDigits + BORD;
+      if (RECORD) recordUse(index, N, t);
+      r = regles[ index ];
+      if (r == FIRE) {
+        FSSP_COUNT(counters.earlyFire++;)
         return 0; //nbFire++;
-      configs[t][N - 1] = r;
+      }
+      cur[N - 1] = r;
       
       t++;
     }
 
     // les 3 dernieres iterations
     while (t <= nbIter && nbFire == 0) {
+      const uint8_t * prev = row(t - 1);
+      uint8_t * cur = row(t);
+      nbCellUpdates += N;
+      FSSP_COUNT(counters.cells += N; counters.lookups += N;)
+
       // premiere cellule a gauche
-      r = regles[ BORD * nbDigits2 + configs[t-1][0] * nbDigits + configs[t-1][1] ];
+      index = BORD * nbDigits2 + prev[0] * nbDigits + prev[1];
+      if (RECORD) recordUse(index, N, t);
+      r = regles[ index ];
       if (r == FIRE)
         nbFire++;
-      configs[t][0] = r;
+      cur[0] = r;
 
       // cellules du centre
-      for(i = 1; i < N - 1; i++) {
-        r = regles[ configs[t-1][i-1] * nbDigits2 + configs[t-1][i] * nbDigits + configs[t-1][i+1] ];
+      i = 1;
+      FSSP_COUNT(i0 = i;)
+      if (useKernel) {
+        FSSP_COUNT(counters.lookups -= (N - 2) - (N - 3 + RowKernel<NbStates>::width()) / RowKernel<NbStates>::width();)
+        nbFire += kernel.row(prev, cur, 1, N - 1);
+        i = N - 1;
+        FSSP_COUNT(i0 = i;)
+      }
+      if (usePairs) {
+        for(; i < N - 2; i += 2) {
+          w = pairs[ window(prev[i-1], prev[i], prev[i+1], prev[i+2]) ];
+          nbFire += pairFires(w);
+          cur[i]   = w & PAIR_CELL;
+          cur[i+1] = (w >> PAIR_BITS) & PAIR_CELL;
+        }
+        FSSP_COUNT(counters.lookups -= (i - i0) / 2;)
+      }
+      for(; i < N - 1; i++) {
+        index = prev[i-1] * nbDigits2 + prev[i] * nbDigits + prev[i+1];
+        if (RECORD) recordUse(index, N, t);
+        r = regles[ index ];
         if (r == FIRE)
           nbFire++;
-        configs[t][i] = r;
+        cur[i] = r;
       }
       
       // cellule a droite
-      r = regles[ configs[t-1][N - 2] * nbDigits2 + configs[t-1][N - 1] * nbDigits + BORD ];
+      index = prev[N - 2] * nbDigits2 + prev[N - 1] * nbDigits + BORD;
+      if (RECORD) recordUse(index, N, t);
+      r = regles[ index ];
       if (r == FIRE)
         nbFire++;
-      configs[t][N - 1] = r;
+      cur[N - 1] = r;
       
       t++;
     }
     
     // nombre de fusiliers apres 2N-2 iterations
-    if (t == 2 * N - 2 + 1)
+    if (t == 2 * N - 2 + 1) {
+      FSSP_COUNT(if (nbFire != N) counters.wrongCount++;)
       return nbFire;
+    } else {
+      FSSP_COUNT(counters.earlyFire++;)
+      return 0;
+    }
+  }
+
+  /*********************************************
+   * two cells by lookup
+   *
+   * The window of 4 cells (a, b, c, d) of the row t-1
+   * gives the 2 cells of the row t at the positions of b and c:
+   * rule(a, b, c) and rule(b, c, d), with the firing flag of each cell.
+   * The states are coded on PAIR_BITS bits (at most 8 digits):
+   * the index of the window is computed without multiplication,
+   * the windows with a digit larger than BORD are not used.
+   *
+   *********************************************/
+  static const int PAIR_BITS = 3;
+  static const int PAIR_CELL = (1 << PAIR_BITS) - 1;
+  static const int PAIR_FIRE_LO = 1 << (2 * PAIR_BITS);
+  static const int PAIR_FIRE_HI = 1 << (2 * PAIR_BITS + 1);
+  static const int PAIR_FIRE = PAIR_FIRE_LO | PAIR_FIRE_HI;
+  static_assert(nbWindows == 1 << (4 * PAIR_BITS), "size of the windows");
+  static_assert(nbDigits <= PAIR_CELL + 1, "too many states for the pairs of cells");
+
+  static int window(int a, int b, int c, int d) {
+    return (a << (3 * PAIR_BITS)) | (b << (2 * PAIR_BITS)) | (c << PAIR_BITS) | d;
+  }
+
+  // number of firing cells of the pair
+  static int pairFires(int w) {
+    return ((w >> (2 * PAIR_BITS)) & 1) + (w >> (2 * PAIR_BITS + 1));
+  }
+
+  static void setPair(uint8_t * pairs, const uint8_t * regles, int a, int b, int c, int d) {
+    int lo = regles[ a * nbDigits2 + b * nbDigits + c ];
+    int hi = regles[ b * nbDigits2 + c * nbDigits + d ];
+
+    pairs[ window(a, b, c, d) ] = (lo & PAIR_CELL) | ((hi & PAIR_CELL) << PAIR_BITS)
+      | (lo == FIRE ? PAIR_FIRE_LO : 0) | (hi == FIRE ? PAIR_FIRE_HI : 0);
+  }
+
+  /*********************************************
+   * compute all the windows of the rules
+   *
+   *********************************************/
+  static void buildPairs(uint8_t * pairs, const uint8_t * regles) {
+    memset(pairs, 0, nbWindows);
+
+    for(int a = 0; a < nbDigits; a++)
+      for(int b = 0; b < nbDigits; b++)
+        for(int c = 0; c < nbDigits; c++)
+          for(int d = 0; d < nbDigits; d++)
+            setPair(pairs, regles, a, b, c, d);
+  }
+
+  /*********************************************
+   * number of windows computed by updatePairs
+   *
+   *********************************************/
+  int updatePairsCost(const uint8_t * regles) const {
+    if (!pairsBuilt)
+      return nbDigits2 * nbDigits2;
+
+    int nb = 0;
+    for(int r = 0; r < nbRules; r++)
+      if (regles[r] != pairRules[r])
+        nb++;
+
+    return nb * 2 * nbDigits;
+  }
+
+  /*********************************************
+   * update the windows with the rules which differ from pairRules:
+   * a rule (a, b, c) is in 2 * nbDigits windows (a, b, c, .) and (., a, b, c)
+   *
+   *********************************************/
+  void updatePairs(const uint8_t * regles) {
+    int r, a, b, c, x;
+
+    if (!pairsBuilt) {
+      buildPairs(pairs, regles);
+      for(r = 0; r < nbRules; r++)
+        pairRules[r] = regles[r];
+      pairsBuilt = true;
+      return;
+    }
+
+    for(r = 0; r < nbRules; r++)
+      if (regles[r] != pairRules[r]) {
+        pairRules[r] = regles[r];
+
+        a = r / nbDigits2;
+        b = (r / nbDigits) % nbDigits;
+        c = r % nbDigits;
+        for(x = 0; x < nbDigits; x++) {
+          setPair(pairs, regles, a, b, c, x);
+          setPair(pairs, regles, x, a, b, c);
+        }
+      }
+  }
+
+#ifdef FSSP_COUNTERS
+  /*********************************************
+   * counters: size which breaks a computed evaluation
+   *
+   *********************************************/
+  static void countFailure(int fitness, int nMax) {
+    EvalCounters & counters = evalCounters();
+
+    if (fitness < nMax)
+      counters.countFailSize(fitness + 1);
+    else
+      counters.completed++;
+  }
+#endif
+
+  /*********************************************
+   * incremental evaluation: record the first use of a rule
+   *
+   *********************************************/
+  void recordUse(int index, int N, int t) {
+    if (firstSize[index] == 0) {
+      firstSize[index] = N;
+      firstTime[index] = t;
+    }
+  }
+
+  /*********************************************
+   * incremental evaluation: loop of eval from the size k (and the time step t)
+   *
+   * input : regles : rules of the automata
+   *         nMax : maximum size of the firing squad
+   *         k : first size to compute
+   *         t : first time step of the size k to compute
+   *         record : true when the diagram of the incumbent is saved
+   *
+   * output : the maximum size solved
+   *
+   *********************************************/
+  int runIncremental(const uint8_t * regles, int nMax, int k, int t, bool record) {
+    int nbFireTot;
+
+    pairsDirty = true;
+    pairsCost = -1;
+    kernelDirty = true;
+
+    if (record) {
+      nbFireTot = evolQuickFrom<true>(regles, k, t);
+      saveSnapshot(k, t);
+    } else
+      nbFireTot = evolQuickFrom<false>(regles, k, t);
+
+    while (nbFireTot == k && k <= nMax) {
+      k++;
+      if (record) {
+        nbFireTot = evolQuickFrom<true>(regles, k, 0);
+        saveSnapshot(k, 0);
+      } else
+        nbFireTot = evolQuickFrom<false>(regles, k, 0);
+    }
+
+    if (k == 2)
+      return 0;
     else
+      return k - 1;
+  }
+
+  /*********************************************
+   * incremental evaluation: 
+   * first column of the part of the diagram computed by evolQuick
+   * for the size N at time step t (rows N-2 to 2N-2)
+   *
+   *********************************************/
+  int snapshotFirstColumn(int N, int t) {
+    int i = 2 * N - 4 - t;
+
+    if (i < 0)
       return 0;
+    else
+      return i;
+  }
+
+  /*********************************************
+   * incremental evaluation: allocate the snapshots of the diagram
+   * for the sizes from 3 to at least sMax
+   *
+   * The snapshots are only allocated for the sizes computed by the incumbent
+   * (until the size which breaks it, about N^2 bytes by size N), and grow
+   * with the fitness of the incumbent: the snapshots already saved are kept.
+   *
+   *********************************************/
+  void allocateSnapshots(int sMax) {
+    if (sMax <= snapshotMaxSize)
+      return;
+
+    // a quarter more sizes than needed: less reallocations when the fitness increases
+    int sAlloc = std::max(sMax, snapshotMaxSize + snapshotMaxSize / 4);
+    if (sAlloc > maxSize)
+      sAlloc = maxSize;
+
+    size_t size = 0;
+    for(int n = 3; n <= sAlloc; n++) {
+      snapshotOffset[n] = size;
+      size += snapshotSize(n);
+    }
+
+    uint8_t * s = new uint8_t[size];
+    if (snapshots != NULL) {
+      if (snapshotMaxSize >= 3)
+        memcpy(s, snapshots, snapshotOffset[snapshotMaxSize] + snapshotSize(snapshotMaxSize));
+      delete [] snapshots;
+    }
+    snapshots = s;
+
+    snapshotMaxSize = sAlloc;
+  }
+
+  // size of the snapshot of the size N
+  size_t snapshotSize(int N) {
+    size_t size = 0;
+    for(int t = N - 2; t <= 2 * N - 2; t++)
+      size += N - snapshotFirstColumn(N, t);
+    return size;
+  }
+
+  /*********************************************
+   * incremental evaluation: copy the part of the diagram computed for the size N
+   * from the time step tStart (the previous rows are unchanged)
+   *
+   *********************************************/
+  void saveSnapshot(int N, int tStart) {
+    allocateSnapshots(N);
+
+    uint8_t * s = snapshots + snapshotOffset[N];
+    int t = N - 2;
+    int i;
+
+    for(; t < tStart; t++)
+      s += N - snapshotFirstColumn(N, t);
+
+    for(; t <= 2 * N - 2; t++) {
+      i = snapshotFirstColumn(N, t);
+      memcpy(s, row(t) + i, N - i);
+      s += N - i;
+    }
+  }
+
+  /*********************************************
+   * incremental evaluation: restore the diagram of the incumbent
+   * before the computation of the size k at time step t
+   *
+   *********************************************/
+  void restoreSnapshot(const uint8_t * regles, int k, int t) {
+    uint8_t * s;
+    int i, n;
+
+    // the size k - 1 which is read by the size k
+    if (k == 3)
+      loadTrace(regles, 2);
+    else {
+      n = k - 1;
+      s = snapshots + snapshotOffset[n];
+      for(int r = n - 2; r <= 2 * n - 2; r++) {
+        i = snapshotFirstColumn(n, r);
+        memcpy(row(r) + i, s, n - i);
+        s += n - i;
+      }
+    }
+
+    // the rows of the size k before t (read by the sizes k and k + 1)
+    s = snapshots + snapshotOffset[k];
+    for(int r = k - 2; r < t; r++) {
+      i = snapshotFirstColumn(k, r);
+      memcpy(row(r) + i, s, k - i);
+      s += k - i;
+    }
   }
   
   /*********************************************
@@ -464,7 +2086,7 @@ private:
    * output : the maximum size solved
    *
    *********************************************/
-  int evalSlow(int * regles, int n) {
+  int evalSlow(const uint8_t * regles, int n) {
     //int nbFireTot = evol(regles, 2);
     // nous supposons que la regle est faite pour que la longueur n=2 fonctionne
     int nbFireTot = 2;
@@ -482,6 +2104,24 @@ private:
       return k - 1;
   }
   
+  /*********************************************
+   * load the trace for evolQuick (created at the first call)
+   *
+   * input : regles : rules of the automata
+   *         nMin : minimum size of the firing squad
+   *
+   *********************************************/
+  void loadTrace(const uint8_t * regles, int nMin) {
+    if (trace == NULL) {
+      createTrace(regles, nMin);
+    } else {
+      // load from the trace
+      for(int i = 0; i < nMin - 1; i++) {
+        row(2 * nMin - 3 - i)[i] = trace[i];
+      }
+    }
+  }
+
   /*********************************************
    * create the trace for evolQuick
    *
@@ -492,15 +2132,12 @@ private:
    *          of the time-space diagram
    *
    *********************************************/
-  void createTrace(int * regles, int nMin) {
+  void createTrace(const uint8_t * regles, int nMin) {
+    FSSP_COUNT(evalCounters().traces++;)
+
     // size 2
-    if (nbStates == 5) {
-      configs[1][0] = 1;
-      configs[1][1] = 1;
-    } else { // nbStates = 6 for example
-      configs[1][0] = 2;
-      configs[1][1] = 2;
-    }
+    row(1)[0] = TRACE;
+    row(1)[1] = TRACE;
  
     int k = 3;
     
@@ -512,10 +2149,91 @@ private:
     
     trace = new int[nMin-1];
     for(int i = 0; i < nMin - 1; i++) {
-      trace[i] = configs[2 * nMin - 3 - i][i];
+      trace[i] = row(2 * nMin - 3 - i)[i];
     }
   }
   
+  /*********************************************
+   * one iteration of the evolution with unused rules:
+   * the UNUSED cells are read as REPOS
+   *
+   * input : regles : rules of the automata
+   *         N : size of the automata
+   *         t : time of the computed row
+   *         prev : row t-1
+   *
+   * output : cur : row t, the cells 0 to min(t, N-1) are computed
+   *                (the next cells are REPOS in prev and cur)
+   *          return the number of firing cells
+   *********************************************/
+  static int stepWithUnused(const uint8_t * regles, int N, int t, const uint8_t * prev, uint8_t * cur) {
+    // nombre d'etats feu
+    int nbFire = 0;
+    
+    // valeur de la regle locale
+    int r;
+    
+    int i;
+    int g, c, d;
+    int valueByDefault = 0; // when unused
+    
+    // last computed cell (the next cells stay REPOS)
+    int last;
+    
+    if (t < N - 1)
+      last = t;
+    else
+      last = N - 1;
+    
+    // premiere cellule a gauche
+    c = prev[0];
+    if (c == UNUSED)
+      c = valueByDefault;
+    d = prev[1];
+    if (d == UNUSED)
+      d = valueByDefault;
+    
+    r = regles[ BORD * nbDigits2 + c * nbDigits + d ];
+    if (r == FIRE)
+      nbFire++;
+    cur[0] = r;
+    
+    // cellules du centre
+    for(i = 1; i < last; i++) {
+      g = prev[i-1];
+      if (g == UNUSED)
+        g = valueByDefault;
+      c = prev[i];
+      if (c == UNUSED)
+        c = valueByDefault;
+      d = prev[i+1];
+      if (d == UNUSED)
+        d = valueByDefault;
+      
+      r = regles[ g * nbDigits2 + c * nbDigits + d ];
+      if (r == FIRE)
+        nbFire++;
+      cur[i] = r;
+    }
+    
+    // cellule a droite (bord, ou avant REPOS)
+    g = prev[last - 1];
+    if (g == UNUSED)
+      g = valueByDefault;
+    c = prev[last];
+    if (c == UNUSED)
+      c = valueByDefault;
+    if (last == N - 1)
+      r = regles[ g * nbDigits2 + c * nbDigits + BORD ];
+    else
+      r = regles[ g * nbDigits2 + c * nbDigits + REPOS ];
+    if (r == FIRE)
+      nbFire++;
+    cur[last] = r;
+    
+    return nbFire;
+  }
+
   /*********************************************
    * evolution of the automate from initial configuration
    * to the first time of firing
@@ -528,7 +2246,7 @@ private:
    * output : number of the firing after 2N-2 iteration
    *          0 else
    *********************************************/
-  int evolWithUnused(int * regles, int N) {
+  int evolWithUnused(const uint8_t * regles, int N) {
     int nbIter = 2 * N - 2;
     
     if (nbIter > maxIteration)
@@ -540,59 +2258,11 @@ private:
     // nombre d'etats feu
     int nbFire = 0;
     
-    // valeur de la regle locale
-    int r;
-    
-    int i, t;
-    int g, c, d;
-    int valueByDefault = 0; // when unused
-    
-    t = 1;
+    int t = 1;
     
     // les iterations suivantes
     while (t <= nbIter && nbFire == 0) {
-      // premiere cellule a gauche
-      c = configs[t-1][0];
-      if (c == UNUSED)
-        c = valueByDefault;
-      d = configs[t-1][1];
-      if (d == UNUSED)
-        d = valueByDefault;
-      
-      r = regles[ BORD * nbDigits2 + c * nbDigits + d ];
-      if (r == FIRE)
-        nbFire++;
-      configs[t][0] = r;
-      
-      // cellules du centre
-      for(i = 1; i < N - 1; i++) {
-        g = configs[t-1][i-1];
-        if (g == UNUSED)
-          g = valueByDefault;
-        c = configs[t-1][i];
-        if (c == UNUSED)
-          c = valueByDefault;
-        d = configs[t-1][i+1];
-        if (d == UNUSED)
-          d = valueByDefault;
-        
-        r = regles[ g * nbDigits2 + c * nbDigits + d ];
-        if (r == FIRE)
-          nbFire++;
-        configs[t][i] = r;
-      }
-      
-      // cellule a droite
-      g = configs[t-1][N - 2];
-      if (g == UNUSED)
-        g = valueByDefault;
-      c = configs[t-1][N - 1];
-      if (c == UNUSED)
-        c = valueByDefault;
-      r = regles[ g * nbDigits2 + c * nbDigits + BORD ];
-      if (r == FIRE)
-        nbFire++;
-      configs[t][N - 1] = r;
+      nbFire = stepWithUnused(regles, N, t, row(t - 1), row(t));
       
       t++;
     }
@@ -603,6 +2273,7 @@ private:
     else
       return 0;
   }
+
   
 	
 
@@ -611,132 +2282,227 @@ private:
   /*********************************************
    * export in svg format
    *
+   * The horizontal runs of cells with the same state are merged into one rectangle,
+   * the colors are classes of a style sheet (see styleSVG).
+   * The text is written by blocks of 1MB.
+   *
    * input :
    *.   regles : solution
    *.   N : size of the firing squad (number of cells)
    *.   all : true: from 2 to N; false: only N
+   *.   blackFire : see styleSVG
    *
    *********************************************/
-  void print(int * regles, int N, const char * fileName, bool all = false) {
-    fstream file(fileName, ios::out);
+  void print(const uint8_t * regles, int N, const char * fileName, bool all = false, bool blackFire = false) {
+    fstream file(fileName, ios::out | ios::binary);
     
     if (file) {
+      std::string buffer;
+      buffer.reserve(svgBlock + 256);
       
-      int nFire ;
       int nbIter ;
       int nInit;
       
       if (all) {
         nInit = 2;
-        headSVG(file, (N * (N + 1) / 2 + (N - 1) * 2) * width, (2 * N) * height);
+        headSVG(buffer, (N * (N + 1) / 2 + (N - 1) * 2) * width, (2 * N) * height, blackFire);
       } else {
         nInit = N;
-        headSVG(file, (N + 1) * width, (2 * N) * height);
+        headSVG(buffer, (N + 1) * width, (2 * N) * height, blackFire);
       }
       
-      // head of the file
       int x = 0;
       int y = 0;
       
       for(int n = nInit; n <= N; n++) {
-        nFire = evolWithUnused(regles, n);
+        evolWithUnused(regles, n);
         
         nbIter= 2 * n - 2;
         
         if (nbIter > maxIteration)
           nbIter = maxIteration;
         
-        // drawing
+        // drawing, until the row of the first fire
         bool fire = false;
-        int i, j;
+        int i, j, k, state;
         for(i = 0; i <= nbIter && !fire; i++) {
-          for(j = 0; j < n; j++) {
-            cellSVG(file, x + j * width, y + i * height, configs[i][j]);
+          j = 0;
+          while (j < n) {
+            state = cell(i, j);
+            k = j + 1;
+            while (k < n && cell(i, k) == state)
+              k++;
+            
+            runSVG(buffer, x + j * width, y + i * height, k - j, state);
             
-            fire = fire || (configs[i][j] == FIRE);
+            fire = fire || (state == FIRE);
+            j = k;
+          }
+          
+          if (buffer.size() >= svgBlock) {
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
           }
         }
         
+        // borders of the cells, on the merged runs
+        gridSVG(buffer, x, y, n, i);
+        
         x += (n+2) * width;
       }
       
       // bottom of file
-      file << "</g> </svg>" << endl;
+      buffer += "</g>\n</svg>\n";
+      file.write(buffer.data(), buffer.size());
       
       file.close();
     } else
       cerr << "print: impossible to open file " << fileName << endl;
   }
   
-  void headSVG(fstream & file, int w, int h) {
-    file << "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
-    << endl
-    << "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.0//EN\" \"http://www.w3.org/TR/2001/REC-SVG-20010904/DTD/svg10.dtd\">"
-    << endl << endl
-    << "<svg" << endl
-    << "xmlns=\"http://www.w3.org/2000/svg\"" << endl
-    << "xmlns:xlink=\"http://www.w3.org/1999/xlink\"" << endl
-    << "xmlns:ev=\"http://www.w3.org/2001/xml-events\"" << endl
-    << "version=\"1.1\"" << endl
-    << "baseProfile=\"full\"" << endl
-    << "width=\"" << w <<"\" height=\"" << h << "\">" << endl // viewBox="0 0 800 400">
-    << "<g stroke-width=\"1px\" stroke=\"black\" fill=\"white\">" << endl;
-  }
-  
-  void cellSVG(fstream & file, int x, int y, int state) {
-    file << "<rect "
-    << "width=\""  << width   << "\" "
-    << "height=\"" << height  << "\" "
-    << "x=\"" << (x + width)  << "\" "
-    << "y=\"" << (y + height) << "\" "
-    << "fill=\"";
+  // size of the blocks written in the svg file
+  static const size_t svgBlock = 1 << 20;
+  
+  void headSVG(std::string & buffer, int w, int h, bool blackFire) {
+    buffer += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.0//EN\" \"http://www.w3.org/TR/2001/REC-SVG-20010904/DTD/svg10.dtd\">\n\n"
+      "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" baseProfile=\"full\" width=\"";
+    appendInt(buffer, w);
+    buffer += "\" height=\"";
+    appendInt(buffer, h);
+    buffer += "\">\n";
+    styleSVG(buffer, blackFire);
+    buffer += "<g>\n";
+  }
+  
+  /*********************************************
+   * grid of the cells of a size: one path of the lines between the cells,
+   * the runs of cells (see runSVG) are drawn without border
+   *
+   * input : x, y : position of the size in the drawing
+   *         n : number of cells by row
+   *         nbRows : number of drawn rows
+   *
+   *********************************************/
+  void gridSVG(std::string & buffer, int x, int y, int n, int nbRows) {
+    int x0 = x + width;
+    int y0 = y + height;
     
-    if (state > FIRE) // == UNUSED
-      file << "grey" ; 
-    else if (state == REPOS)
-      file << "white" ; 
+    buffer += "<path fill=\"none\" stroke=\"black\" stroke-width=\"1px\" d=\"";
+    for(int r = 0; r <= nbRows; r++) {
+      buffer += 'M';
+      appendInt(buffer, x0);
+      buffer += ' ';
+      appendInt(buffer, y0 + r * height);
+      buffer += 'H';
+      appendInt(buffer, x0 + n * width);
+    }
+    for(int c = 0; c <= n; c++) {
+      buffer += 'M';
+      appendInt(buffer, x0 + c * width);
+      buffer += ' ';
+      appendInt(buffer, y0);
+      buffer += 'V';
+      appendInt(buffer, y0 + nbRows * height);
+    }
+    buffer += "\"/>\n";
+  }
+  
+  /*********************************************
+   * palette of the states: class s<state> of the style sheet
+   * (the states larger than FIRE, UNUSED and IMPOSSIBLE, are grey)
+   *
+   * input : blackFire : true: FIRE is black, false: FIRE is red
+   *
+   *********************************************/
+  void styleSVG(std::string & buffer, bool blackFire) {
+    buffer += "<defs><style type=\"text/css\"><![CDATA[\n";
+    for(int state = 0; state <= IMPOSSIBLE; state++) {
+      buffer += ".s";
+      appendInt(buffer, state);
+      buffer += "{fill:";
+      buffer += colorSVG(state, blackFire);
+      buffer += "}\n";
+    }
+    buffer += "]]></style></defs>\n";
+  }
+  
+  // same colors than colorSVG (red, green, blue)
+  static void colorRaster(int state, uint8_t * rgb) {
+    static const uint8_t grey[3] = { 128, 128, 128 };
+    static const uint8_t colors[7][3] = {
+      { 255, 255, 255 },  // REPOS: white
+      {   0,   0, 255 },  // GEN: blue
+      { 255, 255,   0 },  // NONGEN: yellow
+      {   0, 128,   0 },  // NONGENBIS: green
+      { 238, 130, 238 },  // NONGENBIS + 1: violet
+      { 255, 165,   0 },  // NONGENBIS + 2: orange
+      { 255,   0,   0 }   // FIRE: red
+    };
+    const uint8_t * color;
+
+    if (state > FIRE)
+      color = grey;
     else if (state == FIRE)
-      file << "red"  ; 
-    else if (state == GEN)
-      file << "blue" ; 
-    else if (state == NONGEN)
-      file << "yellow" ; 
-    else if (state == NONGENBIS)
-      file << "green" ; 
-    else if (state == NONGENBIS + 1)
-      file << "violet" ; 
-    else if (state == NONGENBIS + 2)
-      file << "orange" ; 
+      color = colors[6];
+    else if (state <= NONGENBIS + 2)
+      color = colors[state];
     else
-      file << "grey" ; 
+      color = grey;
 
-    file << "\"/>" << endl;
+    memcpy(rgb, color, 3);
   }
   
-  void cellSVG_BW(fstream & file, int x, int y, int state) {
-    file << "<rect " << "width=\""  << width   << "\" "<< "height=\"" << height  << "\" " << "x=\"" << (x + width)  << "\" " << "y=\"" << (y + height) << "\" "
-    << "fill=\"";
-    
+  const char * colorSVG(int state, bool blackFire) {
     if (state > FIRE) // == UNUSED
-      file << "grey" ; 
+      return "grey";
     else if (state == REPOS)
-      file << "white" ; 
+      return "white";
     else if (state == FIRE)
-      file << "black"  ; 
+      return blackFire ? "black" : "red";
     else if (state == GEN)
-      file << "blue" ; 
+      return "blue";
     else if (state == NONGEN)
-      file << "yellow" ; 
+      return "yellow";
     else if (state == NONGENBIS)
-      file << "green" ; 
+      return "green";
     else if (state == NONGENBIS + 1)
-      file << "violet" ; 
+      return "violet";
     else if (state == NONGENBIS + 2)
-      file << "orange" ; 
+      return "orange";
     else
-      file << "grey" ; 
-
-    file << "\"/>" << endl;
+      return "grey";
+  }
+  
+  // run of length cells with the same state, from the position (x, y)
+  void runSVG(std::string & buffer, int x, int y, int length, int state) {
+    buffer += "<rect class=\"s";
+    appendInt(buffer, state);
+    buffer += "\" x=\"";
+    appendInt(buffer, x + width);
+    buffer += "\" y=\"";
+    appendInt(buffer, y + height);
+    buffer += "\" width=\"";
+    appendInt(buffer, length * width);
+    buffer += "\" height=\"";
+    appendInt(buffer, height);
+    buffer += "\"/>\n";
+  }
+  
+  static void appendInt(std::string & buffer, int v) {
+    char digits[12];
+    int k = 0;
+    
+    if (v < 0) {
+      buffer += '-';
+      v = -v;
+    }
+    do {
+      digits[k++] = '0' + v % 10;
+      v /= 10;
+    } while (v > 0);
+    while (k > 0)
+      buffer += digits[--k];
   }
   
   /*********************
@@ -748,10 +2514,10 @@ private:
     int maxIter = 2 * n - 1;
     for(int i = 0; i < maxIter; i++) {
       for(int j = 0; j < n; j++) {
-        if (configs[i][j] == REPOS)
+        if (cell(i, j) == REPOS)
           cout << "0" ;
         else
-          cout << configs[i][j] ;
+          cout << cell(i, j) ;
       }
       cout << endl ;
     }
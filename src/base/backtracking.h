@@ -0,0 +1,331 @@
+/*
+  backtracking.h
+
+  Firing Squad Synhronization Problem:
+     Exact search of all the solutions which synchronize the sizes 2 to nMax.
+
+     The automata is simulated with a partial table of rules: the useful rules
+     (see RuleTables::useful) are UNUSED at the beginning.
+     When the simulation reads an UNUSED rule, the search branches on the
+     non-firing values of this rule, and continues the simulation from the same cell:
+     the cells computed before do not use this rule.
+     A branch is pruned when a cell fires before time 2N-2, or when a cell
+     does not fire at time 2N-2. The sizes are computed in increasing order (as eval).
+
+     Only the rules read by the simulation are assigned: the rules of a solution
+     which are still UNUSED can take any value.
+     The free states (see RuleTables::isFree) are interchangeable: a free state
+     which is not used yet is only tried when it is the first one,
+     so there is one solution by permutation of the free states.
+
+     In parallel, the search tree is split at a given number of assigned rules,
+     and the subtrees are explored by the threads of a pool.
+*/
+
+#ifndef __backtracking__h
+#define __backtracking__h
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include <base/solution.h>
+#include <base/threadPool.h>
+
+template <int NbStates>
+class Backtracking {
+public:
+  typedef States<NbStates> S;
+
+  static const int nbRules = S::nbRules;
+  static const int FIRE    = S::FIRE;
+  static const int BORD    = S::BORD;
+
+  /*********************************************
+   * constructor
+   *
+   * input : nMax : maximum size of the firing squad
+   *         nbThreads : number of threads, 0 for the number of cores
+   *         splitDepth : number of assigned rules of the roots of the parallel subtrees
+   *
+   *********************************************/
+  Backtracking(int _nMax, int _nbThreads = 1, int _splitDepth = 8)
+    : nMax(_nMax), nbThreads(_nbThreads), splitDepth(_splitDepth), nbNodes(0), nbSolutions(0), stop(false) {
+  }
+
+  /*********************************************
+   * search of all the solutions
+   *
+   * input : f : function called by f(x) for each solution x (fitness nMax),
+   *             one call at a time; the search stops when f returns false
+   *
+   * output : number of solutions
+   *
+   *********************************************/
+  template <class F>
+  uint64_t search(F & f) {
+    call = &callFunction<F>;
+    context = &f;
+    nbNodes = 0;
+    nbSolutions = 0;
+    stop = false;
+
+    if (nbThreads == 1) {
+      Explorer root(*this, -1);
+      root.run(NULL, 0);
+      nbNodes += root.nodes;
+      return nbSolutions;
+    }
+
+    // roots of the subtrees
+    Explorer root(*this, splitDepth);
+    root.run(NULL, 0);
+    nbNodes += root.nodes;
+
+    ThreadPool pool(nbThreads);
+    std::vector<Explorer*> explorers(pool.size());
+    for(unsigned i = 0; i < explorers.size(); i++)
+      explorers[i] = new Explorer(*this, -1);
+
+    auto task = [&](int thread, int k) {
+      explorers[thread]->run(root.prefixes.data() + root.prefixStart[k], root.prefixStart[k + 1] - root.prefixStart[k]);
+    };
+
+    pool.run(root.prefixStart.size() - 1, task);
+
+    for(unsigned i = 0; i < explorers.size(); i++) {
+      nbNodes += explorers[i]->nodes;
+      delete explorers[i];
+    }
+
+    return nbSolutions;
+  }
+
+  // number of branching nodes of the last search
+  uint64_t nodes() const {
+    return nbNodes;
+  }
+
+  // number of solutions of the last search
+  uint64_t solutions() const {
+    return nbSolutions;
+  }
+
+private:
+  int nMax;
+  int nbThreads;
+  int splitDepth;
+
+  uint64_t nbNodes;
+  std::atomic<uint64_t> nbSolutions;
+  std::atomic<bool> stop;
+
+  // function called for each solution, under the lock
+  std::mutex mutex;
+  bool (*call)(void *, const Solution<NbStates> &);
+  void * context;
+
+  template <class F>
+  static bool callFunction(void * f, const Solution<NbStates> & x) {
+    return (*static_cast<F*>(f))(x);
+  }
+
+  void report(const uint8_t * rules) {
+    Solution<NbStates> x;
+
+    memcpy(x.rules, rules, nbRules);
+    x.rehash();
+    x.fitness(nMax);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stop)
+      return;
+    nbSolutions++;
+    if (!call(context, x))
+      stop = true;
+  }
+
+  /*********************************************
+   * depth first search of one thread
+   *
+   *********************************************/
+  class Explorer {
+  public:
+    // prefixes (index, value) of the subtrees, collected when maxDepth >= 0
+    std::vector<int> prefixes;
+    std::vector<size_t> prefixStart;
+
+    uint64_t nodes;
+
+    Explorer(Backtracking & _owner, int _maxDepth) : nodes(0), owner(_owner), maxDepth(_maxDepth) {
+      // space-time diagram of each size n: 2n-1 rows of n cells
+      offset.resize(owner.nMax + 2);
+      size_t length = 0;
+      for(int n = 2; n <= owner.nMax; n++) {
+        offset[n] = length;
+        length += (2 * n - 1) * n;
+      }
+      diagrams.resize(length);
+
+      prefixStart.push_back(0);
+    }
+
+    /*********************************************
+     * search from the rules of a prefix (the other useful rules are UNUSED)
+     *
+     *********************************************/
+    void run(const int * prefix, size_t length) {
+      for(int i = 0; i < nbRules; i++) {
+        if (!S::tables.possible[i])
+          rules[i] = IMPOSSIBLE;
+        else if (S::tables.fixed[i] >= 0)
+          rules[i] = S::tables.fixed[i];
+        else
+          rules[i] = UNUSED;
+      }
+
+      assigned.clear();
+      for(int v = 0; v < FIRE; v++)
+        nbValues[v] = 0;
+      for(size_t k = 0; k < length; k += 2) {
+        rules[prefix[k]] = prefix[k + 1];
+        assigned.push_back(prefix[k]);
+        nbValues[prefix[k + 1]]++;
+      }
+
+      // the size 2 synchronizes with the fixed rules
+      start(3);
+      explore(3, 1, 0);
+    }
+
+  private:
+    Backtracking & owner;
+    int maxDepth;
+
+    uint8_t rules[nbRules];
+
+    // assigned useful rules, in the order of the branches
+    std::vector<int> assigned;
+
+    // number of assigned rules with each value
+    int nbValues[FIRE];
+
+    std::vector<uint8_t> diagrams;
+    std::vector<size_t> offset;
+
+    // initial configuration of the size n
+    void start(int n) {
+      if (n > owner.nMax)
+        return;
+
+      uint8_t * d = diagrams.data() + offset[n];
+      memset(d, REPOS, (2 * n - 1) * n);
+      d[0] = GEN;
+    }
+
+    /*********************************************
+     * simulation from the cell i at time t of the size n
+     * (the previous cells and the smaller sizes are computed)
+     *
+     *********************************************/
+    void explore(int n, int t, int i) {
+      int g, c, d, r, v, last, nbIter;
+
+      while (n <= owner.nMax) {
+        uint8_t * diagram = diagrams.data() + offset[n];
+        nbIter = 2 * n - 2;
+
+        for(; t <= nbIter; t++) {
+          const uint8_t * prev = diagram + (t - 1) * n;
+          uint8_t * cur = diagram + t * n;
+
+          // the cells after last stay REPOS
+          last = (t < n - 1) ? t : n - 1;
+
+          for(; i <= last; i++) {
+            g = (i == 0) ? BORD : prev[i - 1];
+            c = prev[i];
+            d = (i == n - 1) ? BORD : prev[i + 1];
+
+            r = S::index(g, c, d);
+            v = rules[r];
+
+            if (v == UNUSED) {
+              branch(r, n, t, i);
+              return;
+            }
+
+            // early firing, or no firing at time 2n-2
+            if ((v == FIRE) != (t == nbIter))
+              return;
+
+            cur[i] = v;
+
+            // the cell i-1 at time t+1 (and the cell i for the last one) only uses the known cells:
+            // the firing rules are fixed, the branch is pruned one row before
+            if (t < nbIter) {
+              if (i >= 1 && !nextCell(t + 1 == nbIter, (i == 1) ? BORD : cur[i - 2], cur[i - 1], cur[i]))
+                return;
+              if (i == last && !nextCell(t + 1 == nbIter, (i == 0) ? BORD : cur[i - 1], cur[i], (i == n - 1) ? BORD : cur[i + 1]))
+                return;
+            }
+          }
+          i = 0;
+        }
+
+        // the size n synchronizes
+        n++;
+        t = 1;
+        start(n);
+      }
+
+      owner.report(rules);
+    }
+
+    // the next cell fires only at time 2n-2
+    bool nextCell(bool lastRow, int g, int c, int d) {
+      return (rules[S::index(g, c, d)] == FIRE) == lastRow;
+    }
+
+    void branch(int r, int n, int t, int i) {
+      if (owner.stop)
+        return;
+
+      if (maxDepth >= 0 && (int) assigned.size() == maxDepth) {
+        for(unsigned k = 0; k < assigned.size(); k++) {
+          prefixes.push_back(assigned[k]);
+          prefixes.push_back(rules[assigned[k]]);
+        }
+        // the branch on r is done by the thread of the subtree
+        prefixStart.push_back(prefixes.size());
+        return;
+      }
+
+      nodes++;
+
+      // first free state not used yet
+      int firstFree = -1;
+      for(int v = 0; v < FIRE && firstFree < 0; v++)
+        if (S::isFree(v) && nbValues[v] == 0)
+          firstFree = v;
+
+      assigned.push_back(r);
+      for(int v = 0; v < FIRE && !owner.stop; v++) {
+        if (S::isFree(v) && nbValues[v] == 0 && v != firstFree)
+          continue;
+
+        rules[r] = v;
+        nbValues[v]++;
+        explore(n, t, i);
+        nbValues[v]--;
+      }
+      assigned.pop_back();
+
+      rules[r] = UNUSED;
+    }
+  };
+};
+
+#endif
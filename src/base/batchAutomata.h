@@ -0,0 +1,341 @@
+/*
+  batchAutomata.h
+
+  Firing Squad Synhronization Problem:
+     Evaluation of a batch of 64 solutions in lockstep.
+
+     The cells of the 64 space-time diagrams are bit-sliced:
+     one cell is 3 words of 64 bits (one word by bit of the state),
+     the bit l of each word is the cell of the solution l.
+     The rules of the 64 solutions are compiled into boolean masks,
+     so that one transition computes the cell for the 64 solutions.
+     A transition only considers the neighborhoods present in the alive lanes:
+     this is efficient for batches of similar solutions (neighborhoods, perturbations).
+
+     BatchAutomata is a standalone API: the searches of Automata (hill climber,
+     iterated local search, evalNeighborhood) evaluate single rule mutations
+     with the incremental evaluation, which only simulates from the first size
+     using the mutated rule. Use it to evaluate batches of complete solutions
+     (random rules, solutions of several searches, archives).
+*/
+
+#ifndef __batchAutomata__h
+#define __batchAutomata__h
+
+#include <stdint.h>
+#include <vector>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+template <int NbStates>
+class BatchAutomata {
+public:
+  static const int nbStates  = NbStates;
+  static const int nbDigits  = States<NbStates>::nbDigits;
+  static const int nbDigits2 = States<NbStates>::nbDigits2;
+  static const int nbRules   = States<NbStates>::nbRules;
+
+  static const int FIRE  = States<NbStates>::FIRE;
+  static const int BORD  = States<NbStates>::BORD;
+  static const int TRACE = States<NbStates>::TRACE;
+
+  // number of solutions evaluated in lockstep
+  static const int nbLanes = 64;
+
+  // number of bits of a state
+  static const int nbBits = 3;
+
+  /*********************************************
+   * constructor
+   *
+   * input : N : maximum size of the automata
+   *
+   *********************************************/
+  BatchAutomata(int _maxSize) : maxSize(_maxSize), maxIteration(2 * _maxSize - 2) {
+    configs = new uint64_t[(maxIteration + 1) * maxSize * nbBits];
+
+    eqRow = new uint64_t[(maxSize + 1) * nbDigits];
+
+    for(int v = 0; v < nbDigits; v++) {
+      eqRepos[v] = (v == REPOS) ? ~((uint64_t) 0) : 0;
+      eqBord[v]  = (v == BORD)  ? ~((uint64_t) 0) : 0;
+    }
+  }
+
+  /*********************************************
+   *
+   * destructor
+   *
+   *********************************************/
+  ~BatchAutomata() {
+    delete [] configs;
+    delete [] eqRow;
+  }
+
+  /*********************************************
+   * compute objective function of a batch of solutions
+   * (same fitness than Automata::eval)
+   *
+   * input : x : array of pointers on the solutions
+   *         nb : number of solutions
+   *         nMax : maximum size of the firing squad
+   *
+   *********************************************/
+  void eval(Solution<NbStates> ** x, int nb, int nMax) {
+    if (nMax > maxSize - 1)
+      nMax = maxSize - 1;
+
+    // no size computed by Automata::eval
+    if (nMax < 2) {
+      for(int l = 0; l < nb; l++)
+        x[l]->fitness(0);
+      return;
+    }
+
+    for(int first = 0; first < nb; first += nbLanes) {
+      int nbSol = nb - first;
+      if (nbSol > nbLanes)
+        nbSol = nbLanes;
+
+      evalLanes(x + first, nbSol, nMax);
+    }
+  }
+
+  void eval(std::vector<Solution<NbStates>> & x, int nMax) {
+    std::vector<Solution<NbStates>*> pointers(x.size());
+
+    for(unsigned i = 0; i < x.size(); i++)
+      pointers[i] = &x[i];
+
+    eval(pointers.data(), x.size(), nMax);
+  }
+
+private:
+  // maximum size of the cellular automata
+  int maxSize;
+
+  // maximum number of evaluations
+  int maxIteration;
+
+  // bit-sliced space-time diagram: nbBits words by cell
+  uint64_t * configs;
+
+  // masks of the lanes where the cells of a row are equal to each state
+  uint64_t * eqRow;
+
+  // masks of the constant cells
+  uint64_t eqRepos[nbDigits];
+  uint64_t eqBord[nbDigits];
+
+  // compiled rules: mask of the lanes where each bit of the rule is set
+  uint64_t ruleBits[nbRules][nbBits];
+
+  uint64_t * cell(int t, int i) {
+    return configs + (t * maxSize + i) * nbBits;
+  }
+
+  /*********************************************
+   * evaluation of at most 64 solutions
+   *
+   *********************************************/
+  void evalLanes(Solution<NbStates> ** x, int nb, int nMax) {
+    int l;
+
+    uint64_t alive = (nb == nbLanes) ? ~((uint64_t) 0) : ((((uint64_t) 1) << nb) - 1);
+
+    compileRules(x, nb, alive);
+
+    // initial configuration, and trace of the size 2 (see Automata::createTrace)
+    setCell(cell(0, 0), GEN);
+    setCell(cell(1, 0), TRACE);
+
+    uint64_t fail;
+    int k = 3;
+    while (alive != 0 && k <= nMax + 1) {
+      fail = evolQuick(k, alive);
+
+      for(l = 0; l < nb; l++)
+        if ((fail >> l) & 1)
+          x[l]->fitness(k - 1);
+
+      alive &= ~fail;
+      k++;
+    }
+
+    for(l = 0; l < nb; l++)
+      if ((alive >> l) & 1)
+        x[l]->fitness(nMax);
+  }
+
+  /*********************************************
+   * compile the rules of the solutions into lane masks
+   *
+   * The rules of the first solution are set for all lanes,
+   * then only the rules which differ are modified in the other lanes:
+   * the batches are often neighbors of the same solution.
+   *
+   *********************************************/
+  void compileRules(Solution<NbStates> ** x, int nb, uint64_t lanes) {
+    const uint8_t * ref = x[0]->rules;
+    int r, b;
+
+    for(r = 0; r < nbRules; r++)
+      for(b = 0; b < nbBits; b++)
+        ruleBits[r][b] = ((ref[r] >> b) & 1) ? lanes : 0;
+
+    for(int l = 1; l < nb; l++) {
+      const uint8_t * rules = x[l]->rules;
+      uint64_t bit = ((uint64_t) 1) << l;
+
+      for(r = 0; r < nbRules; r++)
+        if (rules[r] != ref[r]) {
+          for(b = 0; b < nbBits; b++)
+            if ((rules[r] >> b) & 1)
+              ruleBits[r][b] |= bit;
+            else
+              ruleBits[r][b] &= ~bit;
+        }
+    }
+  }
+
+  void setCell(uint64_t * c, int state) {
+    for(int b = 0; b < nbBits; b++)
+      c[b] = ((state >> b) & 1) ? ~((uint64_t) 0) : 0;
+  }
+
+  /*********************************************
+   * masks of the alive lanes where the cell is equal to each state
+   * (the failed lanes are removed to reduce the number of neighborhoods)
+   *
+   *********************************************/
+  void equalities(const uint64_t * c, uint64_t * eq, uint64_t alive) {
+    for(int v = 0; v < nbDigits; v++) {
+      uint64_t m = alive;
+      for(int b = 0; b < nbBits; b++)
+        m &= ((v >> b) & 1) ? c[b] : ~c[b];
+      eq[v] = m;
+    }
+  }
+
+  /*********************************************
+   * transition of a cell for the 64 lanes
+   *
+   * input : eqG, eqC, eqD : equality masks of the neighborhood
+   *         c : new cell
+   *
+   * output : mask of the lanes where the new cell fires
+   *
+   *********************************************/
+  uint64_t transition(const uint64_t * eqG, const uint64_t * eqC, const uint64_t * eqD, uint64_t * c) {
+    uint64_t out[nbBits];
+    uint64_t mgc, m;
+    int b;
+
+    for(b = 0; b < nbBits; b++)
+      out[b] = 0;
+
+    // only the neighborhoods which appear in at least one lane
+    for(int g = 0; g < nbDigits; g++) {
+      if (eqG[g] == 0)
+        continue;
+      for(int cc = 0; cc < nbDigits; cc++) {
+        mgc = eqG[g] & eqC[cc];
+        if (mgc == 0)
+          continue;
+        for(int d = 0; d < nbDigits; d++) {
+          m = mgc & eqD[d];
+          if (m != 0) {
+            const uint64_t * rule = ruleBits[g * nbDigits2 + cc * nbDigits + d];
+            for(b = 0; b < nbBits; b++)
+              out[b] |= m & rule[b];
+          }
+        }
+      }
+    }
+
+    uint64_t fire = ~((uint64_t) 0);
+    for(b = 0; b < nbBits; b++) {
+      c[b] = out[b];
+      fire &= ((FIRE >> b) & 1) ? out[b] : ~out[b];
+    }
+
+    return fire;
+  }
+
+  /*********************************************
+   * evolQuick (see Automata::evolQuick) for the alive lanes
+   *
+   *   IMPORTANT:
+   *   we suppose that the size N-1 (i.e. configs)
+   *   has been computed (and synchronized the firing squad) for the alive lanes
+   *
+   * input : N : size of the automata
+   *         alive : mask of the lanes to compute
+   *
+   * output : mask of the lanes which do not synchronize the size N
+   *********************************************/
+  uint64_t evolQuick(int N, uint64_t alive) {
+    uint64_t fail = 0;
+    uint64_t fire, anyFire, allFire;
+    uint64_t eqG[nbDigits];
+    int i, t;
+
+    // les premieres iterations en utilisant la propriete de quiescence 000 -> 0
+    equalities(cell(N - 3, N - 3), eqG, alive);
+    fail |= transition(eqG, eqRepos, eqRepos, cell(N - 2, N - 2));
+    setCell(cell(N - 2, N - 1), REPOS);
+
+    // les iterations suivantes jusqu'au bord gauche
+    t = N - 1;
+    while (t < 2 * N - 4 && (alive & ~fail) != 0) {
+      for(i = 2 * N - 5 - t; i < N; i++)
+        equalities(cell(t - 1, i), eqRow + i * nbDigits, alive & ~fail);
+
+      // cellules du centre
+      for(i = 2 * N - 4 - t; i < N - 1; i++)
+        fail |= transition(eqRow + (i - 1) * nbDigits, eqRow + i * nbDigits, eqRow + (i + 1) * nbDigits, cell(t, i));
+
+      // cellule a droite
+      fail |= transition(eqRow + (N - 2) * nbDigits, eqRow + (N - 1) * nbDigits, eqBord, cell(t, N - 1));
+
+      t++;
+    }
+
+    // les 3 dernieres iterations
+    while (t <= 2 * N - 2 && (alive & ~fail) != 0) {
+      for(i = 0; i < N; i++)
+        equalities(cell(t - 1, i), eqRow + i * nbDigits, alive & ~fail);
+
+      // premiere cellule a gauche
+      fire = transition(eqBord, eqRow, eqRow + nbDigits, cell(t, 0));
+      anyFire = fire;
+      allFire = fire;
+
+      // cellules du centre
+      for(i = 1; i < N - 1; i++) {
+        fire = transition(eqRow + (i - 1) * nbDigits, eqRow + i * nbDigits, eqRow + (i + 1) * nbDigits, cell(t, i));
+        anyFire |= fire;
+        allFire &= fire;
+      }
+
+      // cellule a droite
+      fire = transition(eqRow + (N - 2) * nbDigits, eqRow + (N - 1) * nbDigits, eqBord, cell(t, N - 1));
+      anyFire |= fire;
+      allFire &= fire;
+
+      // all the cells fire at time 2N-2, and not before
+      if (t < 2 * N - 2)
+        fail |= anyFire;
+      else
+        fail |= ~allFire;
+
+      t++;
+    }
+
+    return fail & alive;
+  }
+
+};
+
+#endif
@@ -0,0 +1,235 @@
+/*
+  checkpoint.h
+
+  Firing Squad Synhronization Problem:
+     Checkpoint of an iterated local search (see Automata::iteratedLocalSearch):
+     initial solution (hash of its rules), current and best solutions,
+     number of done iterations, state of the random generator.
+
+     The file is binary:
+       header (40 bytes) : magic "FSSPCKP1", version, number of states, nMax, maxIter,
+                           number of done iterations (uint64), hash of the initial solution (uint64)
+       2 solutions       : fitness (int32, -1 for an invalid fitness), rules (one byte by rule)
+       random state      : size (uint32), then text of the generator (see Random::state)
+     The integers are stored in the byte order of the machine (little endian on x86).
+
+     The file is written into a temporary file, synchronized on the disk,
+     then renamed: a crash leaves the previous checkpoint or the new one, never a partial file.
+
+     SIGINT and SIGTERM can be caught (see catchSignals): the search writes
+     a checkpoint and stops at the end of the current iteration.
+     The previous handlers are restored at the end of the search.
+*/
+
+#ifndef __checkpoint__h
+#define __checkpoint__h
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <base/solution.h>
+
+template <int NbStates>
+class Checkpoint {
+public:
+  static const uint32_t version = 3;
+
+  static const int headerSize = 40;
+
+  static const int nbRules = States<NbStates>::nbRules;
+
+  // search
+  int nMax;
+  int maxIter;
+
+  // number of done iterations
+  uint64_t iteration;
+
+  // hash of the rules of the initial solution (see Solution::hash)
+  uint64_t initial;
+
+  Solution<NbStates> current;
+  Solution<NbStates> best;
+
+  // state of the random generator (see Random::state)
+  std::string randomState;
+
+  Checkpoint() : nMax(0), maxIter(0), iteration(0), initial(0) {
+  }
+
+  /*********************************************
+   * write the checkpoint (temporary file, then rename)
+   *
+   * output : true when the checkpoint is on the disk
+   *
+   *********************************************/
+  bool save(const char * fileName) const {
+    std::string data(headerSize, '\0');
+    uint32_t v;
+    uint64_t it = iteration;
+    int32_t n;
+
+    memcpy(&data[0], "FSSPCKP1", 8);
+    v = version;             memcpy(&data[8], &v, 4);
+    v = NbStates;            memcpy(&data[12], &v, 4);
+    n = nMax;                memcpy(&data[16], &n, 4);
+    n = maxIter;             memcpy(&data[20], &n, 4);
+    memcpy(&data[24], &it, 8);
+    memcpy(&data[32], &initial, 8);
+
+    putSolution(data, current);
+    putSolution(data, best);
+
+    v = randomState.size();
+    data.append((const char *) &v, 4);
+    data += randomState;
+
+    std::string tmpName = std::string(fileName) + ".tmp";
+
+    int fd = open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      std::cerr << "Checkpoint: impossible to open " << tmpName << std::endl;
+      return false;
+    }
+
+    bool ok = write(fd, data.data(), data.size()) == (ssize_t) data.size() && fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || rename(tmpName.c_str(), fileName) != 0) {
+      std::cerr << "Checkpoint: impossible to write " << fileName << std::endl;
+      unlink(tmpName.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  /*********************************************
+   * read a checkpoint
+   *
+   * output : false when the file does not exist, or is not a checkpoint of NbStates states
+   *
+   *********************************************/
+  bool load(const char * fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    std::string data;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+      data.append(buffer, n);
+    close(fd);
+
+    size_t solutionsEnd = headerSize + 2 * (4 + nbRules);
+    uint32_t v;
+
+    if (data.size() < solutionsEnd + 4 || memcmp(data.data(), "FSSPCKP1", 8) != 0) {
+      std::cerr << "Checkpoint: " << fileName << " is not a checkpoint" << std::endl;
+      return false;
+    }
+
+    memcpy(&v, &data[8], 4);
+    uint32_t states;
+    memcpy(&states, &data[12], 4);
+    uint32_t length;
+    memcpy(&length, &data[solutionsEnd], 4);
+
+    if (v != version || states != (uint32_t) NbStates || data.size() != solutionsEnd + 4 + length) {
+      std::cerr << "Checkpoint: " << fileName << " is not a checkpoint of " << NbStates << " states" << std::endl;
+      return false;
+    }
+
+    int32_t i32;
+    memcpy(&i32, &data[16], 4); nMax = i32;
+    memcpy(&i32, &data[20], 4); maxIter = i32;
+    memcpy(&iteration, &data[24], 8);
+    memcpy(&initial, &data[32], 8);
+
+    getSolution(data.data() + headerSize, current);
+    getSolution(data.data() + headerSize + 4 + nbRules, best);
+
+    randomState.assign(data, solutionsEnd + 4, length);
+
+    return true;
+  }
+
+  /*********************************************
+   * SIGINT and SIGTERM: set the stop flag (see stopRequested)
+   * instead of the handlers installed before
+   *
+   * input : on : true: catch the signals (the previous handlers are saved),
+   *              false: restore the previous handlers
+   *
+   *********************************************/
+  static void catchSignals(bool on) {
+    static struct sigaction previous[2];
+    static bool caught = false;
+
+    if (on == caught)
+      return;
+
+    if (on) {
+      struct sigaction action;
+
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = &onSignal;
+      sigemptyset(&action.sa_mask);
+
+      sigaction(SIGINT, &action, &previous[0]);
+      sigaction(SIGTERM, &action, &previous[1]);
+    } else {
+      sigaction(SIGINT, &previous[0], NULL);
+      sigaction(SIGTERM, &previous[1], NULL);
+    }
+
+    caught = on;
+  }
+
+  static bool stopRequested() {
+    return stopFlag() != 0;
+  }
+
+  static void clearStop() {
+    stopFlag() = 0;
+  }
+
+private:
+  static volatile sig_atomic_t & stopFlag() {
+    static volatile sig_atomic_t flag = 0;
+    return flag;
+  }
+
+  static void onSignal(int) {
+    stopFlag() = 1;
+  }
+
+  static void putSolution(std::string & data, const Solution<NbStates> & x) {
+    int32_t fitness = x.invalid() ? -1 : x.fitness();
+
+    data.append((const char *) &fitness, 4);
+    data.append((const char *) x.rules, nbRules);
+  }
+
+  static void getSolution(const char * data, Solution<NbStates> & x) {
+    int32_t fitness;
+
+    memcpy(&fitness, data, 4);
+    memcpy(x.rules, data + 4, nbRules);
+    x.rehash();
+
+    if (fitness >= 0)
+      x.fitness(fitness);
+    else
+      x.invalidate();
+  }
+};
+
+#endif
@@ -0,0 +1,249 @@
+/*
+  counters.h
+
+  Firing Squad Synhronization Problem:
+     Optional counters of the evaluation (compile with -DFSSP_COUNTERS):
+     computed cells, lookups of the rules, size which breaks each evaluation,
+     reason of the failure (early firing, or wrong number of firing cells at time 2N-2),
+     time spent by band of sizes.
+
+     The counters are thread local (evalCounters()), without lock in the evaluation.
+     The counters of all the threads (the pool threads included) are merged
+     by allEvalCounters(), and can be printed in JSON.
+     Without FSSP_COUNTERS, FSSP_COUNT(...) is empty: no cost in the evaluation.
+*/
+
+#ifndef __counters__h
+#define __counters__h
+
+#ifdef FSSP_COUNTERS
+#define FSSP_COUNT(x) x
+#else
+#define FSSP_COUNT(x)
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+class EvalCounters {
+public:
+  // band b : sizes from 2^b to 2^(b+1) - 1
+  static const int nbBands = 32;
+
+  // the failed sizes from maxFailSize are counted together
+  static const int maxFailSize = 4096;
+
+  // number of evaluations (eval, evalIncremental) and of traces (createTrace)
+  uint64_t evaluations;
+  uint64_t traces;
+
+  // computed cells, and lookups of the rules (one lookup for two cells, see Automata::pairs)
+  uint64_t cells;
+  uint64_t lookups;
+
+  // failed sizes: a cell fires before 2N-2, or not all the cells fire at 2N-2
+  uint64_t earlyFire;
+  uint64_t wrongCount;
+
+  // failSize[n] : number of evaluations broken by the size n (n < maxFailSize),
+  // failSize[maxFailSize] : broken by a size at least maxFailSize,
+  // completed : number of evaluations which synchronize all the sizes until nMax
+  uint64_t failSize[maxFailSize + 1];
+  uint64_t completed;
+
+  // number of computed sizes, and time (ns) by band of sizes
+  uint64_t bandSizes[nbBands];
+  uint64_t bandTime[nbBands];
+
+  EvalCounters() {
+    reset();
+  }
+
+  void reset() {
+    evaluations = 0;
+    traces = 0;
+    cells = 0;
+    lookups = 0;
+    earlyFire = 0;
+    wrongCount = 0;
+    for(int n = 0; n <= maxFailSize; n++)
+      failSize[n] = 0;
+    completed = 0;
+    for(int b = 0; b < nbBands; b++) {
+      bandSizes[b] = 0;
+      bandTime[b] = 0;
+    }
+  }
+
+  void countFailSize(int n) {
+    failSize[std::min(n, (int) maxFailSize)]++;
+  }
+
+  static int band(int N) {
+    int b = 0;
+    while (N > 1 && b < nbBands - 1) {
+      N >>= 1;
+      b++;
+    }
+    return b;
+  }
+
+  /*********************************************
+   * add the counters of an other thread
+   *
+   *********************************************/
+  void add(const EvalCounters & c) {
+    evaluations += c.evaluations;
+    traces += c.traces;
+    cells += c.cells;
+    lookups += c.lookups;
+    earlyFire += c.earlyFire;
+    wrongCount += c.wrongCount;
+    for(int n = 0; n <= maxFailSize; n++)
+      failSize[n] += c.failSize[n];
+    completed += c.completed;
+    for(int b = 0; b < nbBands; b++) {
+      bandSizes[b] += c.bandSizes[b];
+      bandTime[b] += c.bandTime[b];
+    }
+  }
+
+  void printJSON(std::ostream & _os) const {
+    _os << "{\"evaluations\": " << evaluations
+        << ", \"traces\": " << traces
+        << ", \"cells\": " << cells
+        << ", \"lookups\": " << lookups
+        << ", \"failures\": {\"earlyFire\": " << earlyFire << ", \"wrongCount\": " << wrongCount << "}"
+        << ", \"completed\": " << completed
+        << ", \"failSize\": {";
+
+    bool first = true;
+    for(int n = 0; n <= maxFailSize; n++)
+      if (failSize[n] > 0) {
+        if (!first)
+          _os << ", ";
+        first = false;
+        _os << "\"" << n << (n == maxFailSize ? "+" : "") << "\": " << failSize[n];
+      }
+
+    _os << "}, \"sizeBands\": [";
+
+    first = true;
+    for(int b = 0; b < nbBands; b++)
+      if (bandSizes[b] > 0) {
+        if (!first)
+          _os << ", ";
+        first = false;
+        _os << "{\"from\": " << (((uint64_t) 1) << b) << ", \"to\": " << (((uint64_t) 1) << (b + 1)) - 1
+            << ", \"sizes\": " << bandSizes[b] << ", \"ns\": " << bandTime[b] << "}";
+      }
+
+    _os << "]}";
+  }
+};
+
+/*********************************************
+ * counters of the threads: the counters of the running threads,
+ * and the sum of the counters of the ended threads
+ *
+ *********************************************/
+class EvalCountersRegistry {
+public:
+  std::mutex mutex;
+  std::vector<EvalCounters*> running;
+  EvalCounters ended;
+
+  static EvalCountersRegistry & instance() {
+    static EvalCountersRegistry registry;
+
+    return registry;
+  }
+};
+
+// counters of one thread, registered during the life of the thread
+class ThreadEvalCounters {
+public:
+  EvalCounters counters;
+
+  ThreadEvalCounters() {
+    EvalCountersRegistry & r = EvalCountersRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    r.running.push_back(&counters);
+  }
+
+  ~ThreadEvalCounters() {
+    EvalCountersRegistry & r = EvalCountersRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    r.ended.add(counters);
+    r.running.erase(std::find(r.running.begin(), r.running.end(), &counters));
+  }
+};
+
+/*********************************************
+ * counters of the current thread
+ *
+ *********************************************/
+inline EvalCounters & evalCounters() {
+  static thread_local ThreadEvalCounters counters;
+
+  return counters.counters;
+}
+
+/*********************************************
+ * sum of the counters of all the threads
+ * (to call when the other threads do not evaluate, e.g. after ThreadPool::run)
+ *
+ *********************************************/
+inline EvalCounters allEvalCounters() {
+  EvalCountersRegistry & r = EvalCountersRegistry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  EvalCounters sum(r.ended);
+  for(unsigned i = 0; i < r.running.size(); i++)
+    sum.add(*r.running[i]);
+
+  return sum;
+}
+
+/*********************************************
+ * reset of the counters of all the threads
+ * (to call when the other threads do not evaluate)
+ *
+ *********************************************/
+inline void resetEvalCounters() {
+  EvalCountersRegistry & r = EvalCountersRegistry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  r.ended.reset();
+  for(unsigned i = 0; i < r.running.size(); i++)
+    r.running[i]->reset();
+}
+
+/*********************************************
+ * time of the computation of a size (until the end of the scope)
+ *
+ *********************************************/
+class SizeTimer {
+public:
+  SizeTimer(int N) : band(EvalCounters::band(N)), start(std::chrono::steady_clock::now()) {
+  }
+
+  ~SizeTimer() {
+    EvalCounters & c = evalCounters();
+
+    c.bandSizes[band]++;
+    c.bandTime[band] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+  int band;
+  std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,110 @@
+/*
+  fitnessCache.h
+
+  Firing Squad Synhronization Problem:
+     Bounded cache of the fitness values, indexed by the hash of the rules
+     (see Solution::hash). The local searches accept the moves of equal fitness,
+     and often evaluate again the same rules.
+
+     The cache is direct-mapped, and can be shared by several threads without lock:
+     each slot is one atomic word with the high bits of the hash and the fitness.
+     A new entry replaces the previous one of the slot.
+     All the fitness values of a cache are computed with the same nMax.
+*/
+
+#ifndef __fitnessCache__h
+#define __fitnessCache__h
+
+#include <atomic>
+#include <iostream>
+#include <stdint.h>
+
+class FitnessCache {
+public:
+  /*********************************************
+   * constructor
+   *
+   * input : nMax : maximum size of the firing squad of the fitness values
+   *         log2Size : the cache has 2^log2Size slots (8 bytes by slot)
+   *
+   *********************************************/
+  FitnessCache(int _nMax, unsigned log2Size = 16) : fitnessNMax(_nMax), mask((((uint64_t) 1) << log2Size) - 1), nbHits(0), nbMisses(0) {
+    slots = new std::atomic<uint64_t>[mask + 1];
+
+    clear();
+  }
+
+  ~FitnessCache() {
+    delete [] slots;
+  }
+
+  int nMax() const {
+    return fitnessNMax;
+  }
+
+  /*********************************************
+   * search the fitness of the rules with the given hash
+   *
+   * output : fitness : fitness value when found
+   *          return true when found
+   *
+   *********************************************/
+  bool find(uint64_t hash, int & fitness) {
+    uint64_t e = slots[hash & mask].load(std::memory_order_relaxed);
+
+    if (e != 0 && (e & TAG) == (hash & TAG)) {
+      fitness = (int) (e & ~TAG) - 1;
+      nbHits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+
+    nbMisses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void insert(uint64_t hash, int fitness) {
+    slots[hash & mask].store((hash & TAG) | (uint64_t) (fitness + 1), std::memory_order_relaxed);
+  }
+
+  void clear() {
+    for(uint64_t i = 0; i <= mask; i++)
+      slots[i].store(0, std::memory_order_relaxed);
+
+    nbHits = 0;
+    nbMisses = 0;
+  }
+
+  // statistics
+  uint64_t hits() const {
+    return nbHits.load();
+  }
+
+  uint64_t misses() const {
+    return nbMisses.load();
+  }
+
+  double hitRate() const {
+    uint64_t n = hits() + misses();
+
+    return (n == 0) ? 0.0 : (double) hits() / n;
+  }
+
+  void printOn(std::ostream & _os) const {
+    _os << "hits " << hits() << " misses " << misses() << " rate " << hitRate();
+  }
+
+private:
+  // the 16 low bits of a slot are the fitness + 1 (0: empty slot)
+  static const uint64_t TAG = ~((uint64_t) 0xFFFF);
+
+  int fitnessNMax;
+
+  uint64_t mask;
+
+  std::atomic<uint64_t> * slots;
+
+  std::atomic<uint64_t> nbHits;
+  std::atomic<uint64_t> nbMisses;
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*
+  neutralNetwork.h
+
+  Firing Squad Synhronization Problem:
+     Exploration of the neutral network of a solution:
+     the solutions connected by single rule mutations with a fitness
+     at least the target fitness.
+
+     All the neighbors of a solution of the network are evaluated in parallel
+     (see Automata::evalNeighborhood), the neighbors with a fitness at least the target
+     are explored when their rules are not visited yet. The distinct solutions are counted
+     with their canonical form (see Solution::canonicalForm): the mutations of the unused rules
+     are explored, but they are not new solutions.
+     The network is explored in breadth first or depth first order,
+     until all the network is visited, or the memory budget is reached.
+*/
+
+#ifndef __neutralNetwork__h
+#define __neutralNetwork__h
+
+#include <deque>
+#include <unordered_set>
+#include <vector>
+#include <stdint.h>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+template <int NbStates>
+class NeutralNetwork {
+public:
+  static const int FIRE = States<NbStates>::FIRE;
+
+  // estimation of the memory of a visited solution (hash set)
+  static const size_t visitedBytes = 48;
+
+  /*********************************************
+   * constructor
+   *
+   * input : maxSize : maximum size of the automata
+   *         nMax : maximum size of the firing squad
+   *         target : minimum fitness of the solutions of the network
+   *         nbThreads : number of threads of the evaluation of the neighbors (0: number of cores)
+   *         memoryBudget : maximum memory (bytes) of the visited solutions and of the solutions to explore
+   *         depthFirst : true: depth first, false: breadth first
+   *
+   *********************************************/
+  NeutralNetwork(int maxSize, int _nMax, int _target, int nbThreads = 0, size_t _memoryBudget = ((size_t) 1) << 30, bool _depthFirst = false)
+    : ca(maxSize), nMax(_nMax), target(_target), memoryBudget(_memoryBudget), depthFirst(_depthFirst), completed(false) {
+    ca.setNbThreads(nbThreads);
+  }
+
+  /*********************************************
+   * exploration of the neutral network of a solution
+   *
+   * input : x : first solution of the network
+   *         f : function called by f(y) for each distinct solution y of the network
+   *             (x included when its fitness is at least the target);
+   *             the exploration stops when f returns false
+   *
+   * output : number of distinct solutions of the network found
+   *
+   *********************************************/
+  template <class F>
+  uint64_t explore(const Solution<NbStates> & x, F & f) {
+    std::deque< Solution<NbStates> > frontier;
+    std::vector<int> out;
+    Solution<NbStates> y(x);
+
+    // canonical hash of the neighbors in the network, computed by the threads of the evaluation
+    std::vector<uint64_t> canonical;
+    auto canonicalHash = [&](int, const Solution<NbStates> & z, int j, int v) {
+      if (z.fitness() >= target)
+        canonical[j * FIRE + v] = z.canonicalHash();
+    };
+
+    visitedSet.clear();
+    distinctSet.clear();
+    completed = false;
+
+    ca.eval(y, nMax);
+    if (y.fitness() < target) {
+      completed = true;
+      return 0;
+    }
+
+    visitedSet.insert(y.hash());
+    distinctSet.insert(y.canonicalHash());
+    frontier.push_back(y);
+    if (!f(y))
+      return distinctSet.size();
+
+    bool full = false;
+
+    while (!frontier.empty()) {
+      if (depthFirst) {
+        y = frontier.back();
+        frontier.pop_back();
+      } else {
+        y = frontier.front();
+        frontier.pop_front();
+      }
+
+      canonical.resize(y.indices.size() * FIRE);
+      ca.evalNeighborhood(y, nMax, out, canonicalHash);
+
+      for(unsigned j = 0; j < y.indices.size(); j++) {
+        int index = y.indices[j];
+        int value = y.rules[index];
+
+        for(int v = 0; v < FIRE; v++) {
+          if (v == value || out[j * FIRE + v] < target)
+            continue;
+
+          if (memory(frontier.size()) >= memoryBudget) {
+            full = true;
+            break;
+          }
+
+          Solution<NbStates> z(y);
+          z.setRule(index, v);
+          z.fitness(out[j * FIRE + v]);
+
+          if (!visitedSet.insert(z.hash()).second)
+            continue;
+
+          frontier.push_back(z);
+          if (distinctSet.insert(canonical[j * FIRE + v]).second && !f(z))
+            return distinctSet.size();
+        }
+
+        if (full)
+          return distinctSet.size();
+      }
+    }
+
+    completed = true;
+
+    return distinctSet.size();
+  }
+
+  // number of distinct solutions (canonical forms) of the last exploration
+  uint64_t visited() const {
+    return distinctSet.size();
+  }
+
+  // number of explored solutions (rules) of the last exploration
+  uint64_t explored() const {
+    return visitedSet.size();
+  }
+
+  // true when all the network is visited by the last exploration
+  bool complete() const {
+    return completed;
+  }
+
+private:
+  Automata<NbStates> ca;
+
+  int nMax;
+  int target;
+  size_t memoryBudget;
+  bool depthFirst;
+
+  bool completed;
+
+  // hash of the rules of the explored solutions
+  std::unordered_set<uint64_t> visitedSet;
+
+  // hash of the canonical forms of the distinct solutions
+  std::unordered_set<uint64_t> distinctSet;
+
+  size_t memory(size_t nbFrontier) const {
+    return (visitedSet.size() + distinctSet.size()) * visitedBytes + nbFrontier * sizeof(Solution<NbStates>);
+  }
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+  random.h
+
+  Firing Squad Synhronization Problem:
+     Random number generator of a search.
+     Each search (or thread) has its own generator:
+     no global state like rand()/srand().
+
+     The generator is xoshiro256** (256 bits of state, seeded by splitmix64).
+     The streams of a seed (see the constructor) are separated by jumps of 2^128 numbers:
+     the threads of a search draw from non-overlapping sequences of the same seed.
+     The random integers between 0 and n - 1 have no modulo bias
+     (multiplication and rejection of Lemire).
+*/
+
+#ifndef __random__h
+#define __random__h
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+class Random {
+public:
+  typedef uint64_t result_type;
+
+  /*********************************************
+   * constructor
+   *
+   * input : seed : seed of the generator
+   *         stream : number of the stream of the seed (one by thread)
+   *
+   *********************************************/
+  Random(uint64_t _seed = 0, unsigned stream = 0) {
+    seed(_seed);
+    for(unsigned k = 0; k < stream; k++)
+      jump();
+  }
+
+  void seed(uint64_t _seed) {
+    // splitmix64: the state is never 0
+    for(int i = 0; i < 4; i++) {
+      _seed += 0x9E3779B97F4A7C15ULL;
+      uint64_t z = _seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      s[i] = z ^ (z >> 31);
+    }
+  }
+
+  /*********************************************
+   * next random number of 64 bits
+   *
+   *********************************************/
+  uint64_t next() {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+  }
+
+  // the generator can be used by the random algorithms of the standard library
+  static constexpr uint64_t min() {
+    return 0;
+  }
+
+  static constexpr uint64_t max() {
+    return ~((uint64_t) 0);
+  }
+
+  uint64_t operator()() {
+    return next();
+  }
+
+  /*********************************************
+   * random integer between 0 and n - 1 (n > 0), without bias
+   *
+   *********************************************/
+  int operator()(int n) {
+    uint32_t range = n;
+    uint64_t m = (next() >> 32) * range;
+    uint32_t low = (uint32_t) m;
+
+    if (low < range) {
+      // the numbers below 2^32 mod n are rejected
+      uint32_t threshold = -range % range;
+      while (low < threshold) {
+        m = (next() >> 32) * range;
+        low = (uint32_t) m;
+      }
+    }
+
+    return m >> 32;
+  }
+
+  /*********************************************
+   * jump of 2^128 numbers: next stream of the seed
+   *
+   *********************************************/
+  void jump() {
+    static const uint64_t polynomial[4] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                            0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+
+    for(int i = 0; i < 4; i++)
+      for(int b = 0; b < 64; b++) {
+        if (polynomial[i] & (((uint64_t) 1) << b))
+          for(int j = 0; j < 4; j++)
+            t[j] ^= s[j];
+        next();
+      }
+
+    for(int j = 0; j < 4; j++)
+      s[j] = t[j];
+  }
+
+  /*********************************************
+   * state of the generator (see Checkpoint):
+   * the sequence continues from the same number after setState
+   *
+   *********************************************/
+  std::string state() const {
+    std::ostringstream os;
+    os << s[0] << " " << s[1] << " " << s[2] << " " << s[3];
+    return os.str();
+  }
+
+  bool setState(const std::string & _state) {
+    std::istringstream is(_state);
+    uint64_t t[4];
+
+    is >> t[0] >> t[1] >> t[2] >> t[3];
+    if (is.fail() || (t[0] | t[1] | t[2] | t[3]) == 0)
+      return false;
+
+    for(int j = 0; j < 4; j++)
+      s[j] = t[j];
+
+    return true;
+  }
+
+  /*********************************************
+   * generator of the calling thread, seeded once by thread
+   * (the searches called without generator)
+   *
+   *********************************************/
+  static Random & local() {
+    static thread_local Random generator(localSeed());
+    return generator;
+  }
+
+private:
+  uint64_t s[4];
+
+  // seed of the generator of a thread: random device, clock and thread
+  static uint64_t localSeed() {
+    std::random_device device;
+    uint64_t seed = ((uint64_t) device() << 32) ^ device();
+
+    seed ^= (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+    seed ^= std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    return seed;
+  }
+
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+#endif
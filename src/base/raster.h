@@ -0,0 +1,309 @@
+/*
+  raster.h
+
+  Firing Squad Synhronization Problem:
+     Writer of raster images with a palette, row by row (the image is not in memory):
+       - binary PPM (P6),
+       - PNG (color type 3: palette), compressed with a self-contained deflate encoder:
+         one block of fixed Huffman codes, the runs of pixels are copies at distance 1,
+         and the row equal to the previous one is filtered with "Up" (only zeros).
+     The format is chosen from the extension of the file name (.png, otherwise PPM).
+*/
+
+#ifndef __raster__h
+#define __raster__h
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+class RasterWriter {
+public:
+  /*********************************************
+   * constructor: write the head of the file
+   *
+   * input : fileName : name of the file (.png: PNG, otherwise PPM)
+   *         _width, _height : size of the image (pixels)
+   *         _palette : colors of the indices, 3 bytes (red, green, blue) by color
+   *         nbColors : number of colors of the palette (at most 256)
+   *
+   *********************************************/
+  RasterWriter(const char * fileName, int _width, int _height, const uint8_t * _palette, int nbColors)
+    : width(_width), height(_height), nbRows(0), palette(_palette, _palette + 3 * nbColors),
+      previous(_width), bits(0), nbBits(0), adler1(1), adler2(0), last(-1) {
+    size_t n = strlen(fileName);
+    png = (n >= 4 && strcmp(fileName + n - 4, ".png") == 0);
+
+    file.open(fileName, std::ios::out | std::ios::binary);
+    if (!file) {
+      std::cerr << "RasterWriter: impossible to open file " << fileName << std::endl;
+      return;
+    }
+
+    if (png)
+      headPNG();
+    else {
+      std::string head = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+      file.write(head.data(), head.size());
+    }
+  }
+
+  ~RasterWriter() {
+    close();
+  }
+
+  bool isOpen() const {
+    return file.is_open();
+  }
+
+  /*********************************************
+   * write the next row of the image
+   *
+   * input : row : index in the palette of each pixel (width pixels)
+   *
+   *********************************************/
+  void writeRow(const uint8_t * row) {
+    if (!file.is_open() || nbRows >= height)
+      return;
+
+    if (png) {
+      // filter "Up" for a row equal to the previous one
+      uint8_t filter = (nbRows > 0 && memcmp(row, previous.data(), width) == 0) ? 2 : 0;
+
+      deflate(&filter, 1);
+      if (filter == 2) {
+        std::fill(previous.begin(), previous.end(), 0);
+        deflate(previous.data(), width);
+      } else
+        deflate(row, width);
+
+      memcpy(previous.data(), row, width);
+
+      if (buffer.size() >= block)
+        chunk("IDAT", buffer);
+    } else {
+      for(int i = 0; i < width; i++)
+        buffer.append((const char *) &palette[3 * row[i]], 3);
+
+      if (buffer.size() >= block) {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+      }
+    }
+
+    nbRows++;
+  }
+
+  /*********************************************
+   * end of the file (the missing rows are written with the color 0)
+   *
+   *********************************************/
+  void close() {
+    if (!file.is_open())
+      return;
+
+    if (nbRows < height) {
+      std::vector<uint8_t> row(width, 0);
+      while (nbRows < height)
+        writeRow(row.data());
+    }
+
+    if (png) {
+      // end of the block, and checksum of the zlib stream
+      putCode(0, 7);
+      if (nbBits > 0)
+        buffer += (char) bits;
+      bits = 0;
+      nbBits = 0;
+      putBigEndian(buffer, (adler2 << 16) | adler1);
+      chunk("IDAT", buffer);
+      chunk("IEND", buffer);
+    } else
+      file.write(buffer.data(), buffer.size());
+
+    file.close();
+  }
+
+private:
+  // size of the blocks written in the file
+  static const size_t block = 1 << 16;
+
+  std::fstream file;
+  bool png;
+
+  int width;
+  int height;
+  int nbRows;
+
+  std::vector<uint8_t> palette;
+
+  // previous row of the png image
+  std::vector<uint8_t> previous;
+
+  // data waiting to be written
+  std::string buffer;
+
+  // bits of the deflate stream not yet in the buffer
+  uint32_t bits;
+  int nbBits;
+
+  // checksum of the uncompressed data
+  uint32_t adler1, adler2;
+
+  // last uncompressed byte (-1 at the beginning of the stream)
+  int last;
+
+  static void putBigEndian(std::string & s, uint32_t v) {
+    s += (char) (v >> 24);
+    s += (char) (v >> 16);
+    s += (char) (v >> 8);
+    s += (char) v;
+  }
+
+  static uint32_t crc32(uint32_t crc, const uint8_t * data, size_t n) {
+    static const std::vector<uint32_t> table = crcTable();
+
+    crc = ~crc;
+    for(size_t i = 0; i < n; i++)
+      crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+  }
+
+  static std::vector<uint32_t> crcTable() {
+    std::vector<uint32_t> table(256);
+
+    for(uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for(int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+
+    return table;
+  }
+
+  /*********************************************
+   * write a png chunk, and clear the data
+   *
+   *********************************************/
+  void chunk(const char * type, std::string & data) {
+    std::string head;
+    putBigEndian(head, data.size());
+    head.append(type, 4);
+
+    uint32_t crc = crc32(0, (const uint8_t *) type, 4);
+    crc = crc32(crc, (const uint8_t *) data.data(), data.size());
+
+    std::string tail;
+    putBigEndian(tail, crc);
+
+    file.write(head.data(), head.size());
+    file.write(data.data(), data.size());
+    file.write(tail.data(), tail.size());
+
+    data.clear();
+  }
+
+  void headPNG() {
+    file.write("\x89PNG\r\n\x1a\n", 8);
+
+    std::string data;
+    putBigEndian(data, width);
+    putBigEndian(data, height);
+    data += (char) 8;   // bits by pixel
+    data += (char) 3;   // palette
+    data += (char) 0;   // deflate
+    data += (char) 0;   // filter by row
+    data += (char) 0;   // no interlace
+    chunk("IHDR", data);
+
+    data.assign((const char *) palette.data(), palette.size());
+    chunk("PLTE", data);
+
+    // zlib head (deflate, window of 32K), then the head of the only block (last block, fixed codes)
+    buffer += (char) 0x78;
+    buffer += (char) 0x01;
+    putBits(1, 1);
+    putBits(1, 2);
+  }
+
+  // bits in the order of the deflate stream (least significant bit first)
+  void putBits(uint32_t v, int n) {
+    bits |= v << nbBits;
+    nbBits += n;
+    while (nbBits >= 8) {
+      buffer += (char) (bits & 0xFF);
+      bits >>= 8;
+      nbBits -= 8;
+    }
+  }
+
+  // huffman code (most significant bit first)
+  void putCode(uint32_t code, int n) {
+    uint32_t r = 0;
+    for(int k = 0; k < n; k++)
+      r |= ((code >> k) & 1) << (n - 1 - k);
+    putBits(r, n);
+  }
+
+  // fixed huffman codes of the literals and lengths
+  void putSymbol(int s) {
+    if (s < 144)
+      putCode(0x30 + s, 8);
+    else if (s < 256)
+      putCode(0x190 + s - 144, 9);
+    else if (s < 280)
+      putCode(s - 256, 7);
+    else
+      putCode(0xC0 + s - 280, 8);
+  }
+
+  // copy of length bytes (3 to 258) at distance 1
+  void putCopy(int length) {
+    static const int base[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const int extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                   3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    int c = 28;
+    while (base[c] > length)
+      c--;
+
+    putSymbol(257 + c);
+    putBits(length - base[c], extra[c]);
+    // distance 1: code 0 on 5 bits
+    putCode(0, 5);
+  }
+
+  /*********************************************
+   * compress the data: literals, and copies of the previous byte
+   *
+   *********************************************/
+  void deflate(const uint8_t * data, int n) {
+    for(int i = 0; i < n; i++) {
+      adler1 = (adler1 + data[i]) % 65521;
+      adler2 = (adler2 + adler1) % 65521;
+    }
+
+    int i = 0;
+    while (i < n) {
+      int k = i;
+      while (k < n && k - i < 258 && data[k] == last)
+        k++;
+
+      if (k - i >= 3) {
+        putCopy(k - i);
+        i = k;
+      } else {
+        putSymbol(data[i]);
+        last = data[i];
+        i++;
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,267 @@
+/*
+  rowKernel.h
+
+  Firing Squad Synhronization Problem:
+     Vectorized update of the centre cells of a row of the space-time diagram.
+
+     The centre cells only read states before FIRE (a firing cell stops the evolution),
+     so the rules of the centre cells are a compact table of FIRE^3 entries
+     (64 for 5 states, 125 for 6 states) indexed by (g * FIRE + c) * FIRE + d.
+     The index of 16, 32 or 64 cells is computed at once from the bytes of the row,
+     and the new states are byte shuffles of the compact table:
+       - SSSE3 / AVX2 : pshufb on each block of 16 entries, selected by the high bits of the index,
+       - AVX-512 VBMI : one vpermi2b on the 128 entries.
+     The firing cells are counted by a vector compare.
+     The instruction set is chosen at run time (see setLevel); without SSSE3
+     (SSE2 has no byte shuffle) or on other processors, the scalar update is used.
+*/
+
+#ifndef __rowKernel__h
+#define __rowKernel__h
+
+#include <stdint.h>
+#include <string.h>
+
+#include <base/states.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FSSP_ROW_SIMD
+#include <immintrin.h>
+#endif
+
+template <int NbStates>
+class RowKernel {
+public:
+  static const int FIRE      = States<NbStates>::FIRE;
+  static const int nbDigits  = States<NbStates>::nbDigits;
+  static const int nbDigits2 = States<NbStates>::nbDigits2;
+
+  // entries of the compact table, and blocks of 16 entries
+  static const int tableSize = FIRE * FIRE * FIRE;
+  static const int nbBlocks  = (tableSize + 15) / 16;
+
+  // instruction sets, in increasing order
+  enum Level { SCALAR = 0, SSSE3 = 1, AVX2 = 2, AVX512 = 3 };
+
+  RowKernel() {
+    memset(table, 0, sizeof(table));
+
+    // index = mulG[g] + mulC[c] + d
+    for(int s = 0; s < 16; s++) {
+      mulG[s] = (s < FIRE) ? s * FIRE * FIRE : 0;
+      mulC[s] = (s < FIRE) ? s * FIRE : 0;
+    }
+  }
+
+  /*********************************************
+   * compact table of the rules of the centre cells
+   *
+   * input : regles : rules of the automata
+   *
+   *********************************************/
+  void setRules(const uint8_t * regles) {
+    for(int g = 0; g < FIRE; g++)
+      for(int c = 0; c < FIRE; c++)
+        for(int d = 0; d < FIRE; d++)
+          table[(g * FIRE + c) * FIRE + d] = regles[ g * nbDigits2 + c * nbDigits + d ];
+  }
+
+  /*********************************************
+   * update of the cells from to to-1 of a row
+   *
+   * input : prev : previous row (the cells from-1 to to are read)
+   *         from, to : cells to compute
+   *
+   * output : cur : new row
+   *          return the number of firing cells
+   *
+   *********************************************/
+  int row(const uint8_t * prev, uint8_t * cur, int from, int to) const {
+    switch (currentLevel()) {
+#ifdef FSSP_ROW_SIMD
+    case AVX512: return rowAVX512(*this, prev, cur, from, to);
+    case AVX2:   return rowAVX2(*this, prev, cur, from, to);
+    case SSSE3:  return rowSSSE3(*this, prev, cur, from, to);
+#endif
+    default:     return rowScalar(*this, prev, cur, from, to);
+    }
+  }
+
+  // instruction set of the update
+  static int level() {
+    return currentLevel();
+  }
+
+  // true when the update is vectorized
+  static bool enabled() {
+    return currentLevel() > SCALAR;
+  }
+
+  // number of cells by vector
+  static int width() {
+    static const int widths[4] = { 1, 16, 32, 64 };
+    return widths[currentLevel()];
+  }
+
+  static const char * name(int l) {
+    static const char * names[4] = { "scalar", "ssse3", "avx2", "avx512" };
+    return names[l];
+  }
+
+  /*********************************************
+   * choose the instruction set of the update
+   *
+   * input : maxLevel : the best instruction set supported by the processor up to maxLevel
+   *
+   * output : chosen instruction set
+   *
+   *********************************************/
+  static int setLevel(int maxLevel) {
+    currentLevel() = supported(maxLevel);
+    return currentLevel();
+  }
+
+private:
+  // compact table (at most 128 entries are vectorized), and the multiples of the index;
+  // the kernel is a member of the Automata allocated by new (no aligned new in C++14):
+  // the loads are unaligned
+  uint8_t table[128];
+  uint8_t mulG[16];
+  uint8_t mulC[16];
+
+  static int & currentLevel() {
+    static int l = supported(AVX512);
+    return l;
+  }
+
+  static int supported(int maxLevel) {
+    if (tableSize > 128)
+      return SCALAR;
+
+#ifdef FSSP_ROW_SIMD
+    __builtin_cpu_init();
+    if (maxLevel >= AVX512 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi"))
+      return AVX512;
+    if (maxLevel >= AVX2 && __builtin_cpu_supports("avx2"))
+      return AVX2;
+    if (maxLevel >= SSSE3 && __builtin_cpu_supports("ssse3"))
+      return SSSE3;
+#endif
+
+    return SCALAR;
+  }
+
+  static int rowScalar(const RowKernel & k, const uint8_t * prev, uint8_t * cur, int from, int to) {
+    int nbFire = 0;
+    int r;
+
+    for(int i = from; i < to; i++) {
+      r = k.table[ (prev[i-1] * FIRE + prev[i]) * FIRE + prev[i+1] ];
+      if (r == FIRE)
+        nbFire++;
+      cur[i] = r;
+    }
+
+    return nbFire;
+  }
+
+#ifdef FSSP_ROW_SIMD
+  __attribute__((target("ssse3")))
+  static int rowSSSE3(const RowKernel & k, const uint8_t * prev, uint8_t * cur, int from, int to) {
+    const __m128i mg = _mm_loadu_si128((const __m128i *) k.mulG);
+    const __m128i mc = _mm_loadu_si128((const __m128i *) k.mulC);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i fire = _mm_set1_epi8(FIRE);
+
+    __m128i blocks[nbBlocks];
+    for(int b = 0; b < nbBlocks; b++)
+      blocks[b] = _mm_loadu_si128((const __m128i *) (k.table + 16 * b));
+
+    int nbFire = 0;
+    int i = from;
+
+    for(; i + 16 <= to; i += 16) {
+      __m128i g = _mm_loadu_si128((const __m128i *) (prev + i - 1));
+      __m128i c = _mm_loadu_si128((const __m128i *) (prev + i));
+      __m128i d = _mm_loadu_si128((const __m128i *) (prev + i + 1));
+
+      __m128i index = _mm_add_epi8(_mm_add_epi8(_mm_shuffle_epi8(mg, g), _mm_shuffle_epi8(mc, c)), d);
+      __m128i high = _mm_and_si128(_mm_srli_epi16(index, 4), low);
+
+      __m128i r = _mm_setzero_si128();
+      for(int b = 0; b < nbBlocks; b++)
+        r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(blocks[b], index), _mm_cmpeq_epi8(high, _mm_set1_epi8(b))));
+
+      _mm_storeu_si128((__m128i *) (cur + i), r);
+      nbFire += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(r, fire)));
+    }
+
+    return nbFire + rowScalar(k, prev, cur, i, to);
+  }
+
+  __attribute__((target("avx2")))
+  static int rowAVX2(const RowKernel & k, const uint8_t * prev, uint8_t * cur, int from, int to) {
+    const __m256i mg = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) k.mulG));
+    const __m256i mc = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) k.mulC));
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i fire = _mm256_set1_epi8(FIRE);
+
+    __m256i blocks[nbBlocks];
+    for(int b = 0; b < nbBlocks; b++)
+      blocks[b] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) (k.table + 16 * b)));
+
+    int nbFire = 0;
+    int i = from;
+
+    for(; i + 32 <= to; i += 32) {
+      __m256i g = _mm256_loadu_si256((const __m256i *) (prev + i - 1));
+      __m256i c = _mm256_loadu_si256((const __m256i *) (prev + i));
+      __m256i d = _mm256_loadu_si256((const __m256i *) (prev + i + 1));
+
+      __m256i index = _mm256_add_epi8(_mm256_add_epi8(_mm256_shuffle_epi8(mg, g), _mm256_shuffle_epi8(mc, c)), d);
+      __m256i high = _mm256_and_si256(_mm256_srli_epi16(index, 4), low);
+
+      __m256i r = _mm256_setzero_si256();
+      for(int b = 0; b < nbBlocks; b++)
+        r = _mm256_or_si256(r, _mm256_and_si256(_mm256_shuffle_epi8(blocks[b], index), _mm256_cmpeq_epi8(high, _mm256_set1_epi8(b))));
+
+      _mm256_storeu_si256((__m256i *) (cur + i), r);
+      nbFire += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, fire)));
+    }
+
+    return nbFire + rowScalar(k, prev, cur, i, to);
+  }
+
+  // the last cells are masked: no scalar tail
+  __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+  static int rowAVX512(const RowKernel & k, const uint8_t * prev, uint8_t * cur, int from, int to) {
+    const __mmask64 all = ~((__mmask64) 0);
+    const __m512i mg = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i *) k.mulG));
+    const __m512i mc = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i *) k.mulC));
+    const __m512i fire = _mm512_set1_epi8(FIRE);
+    const __m512i t0 = _mm512_loadu_si512((const void *) k.table);
+    const __m512i t1 = _mm512_loadu_si512((const void *) (k.table + 64));
+
+    int nbFire = 0;
+    __mmask64 m;
+
+    for(int i = from; i < to; i += 64) {
+      m = (to - i >= 64) ? all : (((__mmask64) 1) << (to - i)) - 1;
+
+      __m512i g = _mm512_maskz_loadu_epi8(m, prev + i - 1);
+      __m512i c = _mm512_maskz_loadu_epi8(m, prev + i);
+      __m512i d = _mm512_maskz_loadu_epi8(m, prev + i + 1);
+
+      __m512i index = _mm512_add_epi8(_mm512_add_epi8(_mm512_maskz_permutexvar_epi8(all, g, mg), _mm512_maskz_permutexvar_epi8(all, c, mc)), d);
+      __m512i r = _mm512_permutex2var_epi8(t0, index, t1);
+
+      _mm512_mask_storeu_epi8(cur + i, m, r);
+      nbFire += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(m, r, fire));
+    }
+
+    return nbFire;
+  }
+#endif
+};
+
+#endif
@@ -20,153 +20,240 @@ See for reference:
 #define _solution_h
 
 #include <string>
+#include <algorithm>
 
 #include <iostream>
-#include <stdlib.h>     /* srand, rand */
+#include <stdlib.h>
 #include <vector>
 #include <time.h>
+#include <stdint.h>
+
+// states and tables of rules
+#include <base/states.h>
+// random generator (see setRandomRules)
+#include <base/random.h>
+
+/*
+  List of the index of the useful rules (see RuleTables::useful),
+  shared by all the solutions: no allocation
+*/
+class RuleIndexList {
+public:
+  const int * list;
+  int nb;
+
+  unsigned size() const {
+    return nb;
+  }
+
+  int operator[](unsigned i) const {
+    return list[i];
+  }
+
+  int at(unsigned i) const {
+    if (i >= (unsigned) nb) {
+      std::cerr << "RuleIndexList::at: index out of range." << std::endl;
+      abort();
+    }
+    return list[i];
+  }
+
+  const int * begin() const {
+    return list;
+  }
+
+  const int * end() const {
+    return list + nb;
+  }
+};
+
+/*
+  Solution: value type, the rules are stored inside the solution
+  (copy and move without allocation)
+*/
+template <int NbStates>
 class Solution {
 public:
-  // rules vector
-  int * rules;
+  typedef States<NbStates> S;
+
+  static const int nbStates = NbStates;
+
   // size of the rules vector
-  unsigned nbRules ;
+  static const unsigned nbRules = S::nbRules;
+
+  // rules vector
+  uint8_t rules[nbRules];
   
-  std::vector<int> indices;
+  // index of the useful rules (modified by the searches)
+  static const RuleIndexList indices;
   
-  Solution(unsigned nbStates) {
-    unsigned nbDigits = nbStates + 1; // nbStates + BORDER
-    
-    nbRules = nbDigits * nbDigits * nbDigits ;
-    rules = new int[nbRules];
-
-    int FIRE = nbStates - 1;
-    int BORD = nbStates;
-
-    int g, c, d, j;
-    for(int i = 0; i < nbRules; i++) {
-      d = i % nbDigits;
-      j = i / nbDigits;
-      c = j % nbDigits;
-      g = j / nbDigits;
-      
-      if ( ! ( (g < FIRE && c < FIRE && d < FIRE) ||
-              (g == BORD && c < FIRE && d < FIRE) ||
-              (g < FIRE && c < FIRE && d == BORD) )
-          )
-        rules[ i ] = 9; // impossible rules
+  Solution() {
+    for(unsigned i = 0; i < nbRules; i++) {
+      if (!S::tables.possible[i])
+        rules[ i ] = IMPOSSIBLE; // impossible rules
       else
         rules[ i ] = 0;
     }
     
     fitnessValue = 0;
     invalidValue = true;
-    indices = getUsefullRulesIndexList();
+    rehash();
   }
   
-  /*
-
-    Copy constructor
+  Solution(const Solution & _solution) = default;
+  Solution(Solution && _solution) = default;
+  Solution& operator=(const Solution & _solution) = default;
+  Solution& operator=(Solution && _solution) = default;
 
+  static int indexVal(int x,int y,int z){
+    return S::index(x, y, z);
+  }
+	
+  /*
+    Index of the rules modified by the searches (see RuleTables::useful)
   */
-  Solution(const Solution & _solution) {
-    nbRules = _solution.nbRules;
-    rules = new int[nbRules];
-    for(int i = 0; i < nbRules; i++)
-      rules[i] = _solution.rules[i];
+  static std::vector<int> getUsefullRulesIndexList(){
+    return std::vector<int>(indices.begin(), indices.end());
+  }
+
+  void setRandomRules(Random & rng){
+    for (int k = 0 ; k < S::tables.nbUseful ; k++){
+      rules[S::tables.useful[k]] = rng(S::FIRE);
+    } 
     
-    invalidValue = _solution.invalid();
+    setFixedRules();
+  }
+		
+  void setFixedRules(){
+    for (unsigned i = 0 ; i < nbRules ; i++)
+      if (S::tables.fixed[i] >= 0)
+        rules[i] = S::tables.fixed[i];
 
-    if (invalidValue)
-      fitnessValue = 0;
-    else
-      fitnessValue = _solution.fitness();
+    rehash();
   }
-  
+
   /*
-    Equal
+    Zobrist hash of the rules: xor of one random key by (rule, value).
+    The rules have to be modified with setRule to keep the hash,
+    or rehash has to be called after a direct modification of the rules vector.
   */
-  Solution& operator=(const Solution & _solution) {
-    nbRules = _solution.nbRules;
-    for(int i = 0; i < nbRules; i++)
-      rules[i] = _solution.rules[i];
-    
-    invalidValue = _solution.invalid();
-    
-    if (invalidValue)
-      fitnessValue = 0;
-    else
-      fitnessValue = _solution.fitness();
+  uint64_t hash() const {
+    return hashValue;
+  }
 
-    return *this;
+  void setRule(unsigned i, int value) {
+    hashValue ^= key(i, rules[i]) ^ key(i, value);
+    rules[i] = value;
   }
-  
-  ~Solution() {
-    delete [] rules;
+
+  void rehash() {
+    hashValue = 0;
+    for(unsigned i = 0; i < nbRules; i++)
+      hashValue ^= key(i, rules[i]);
   }
-  static int indexVal(int x,int y,int z){
-		return (36*x+6*y+z);
-		
-	}
-	
-  static std::vector<int> getUsefullRulesIndexList(){
-		std::vector<int> res;
-		
-		for (int g = 0; g<6 ; g++){
-			for (int c = 0; c< 6; c++){
-				for (int d = 0; d< 6; d++){
-					if (g == 4 || c == 4 || d == 4) continue; //break ? // si feu pas de suite
-					if (c == 5 || (g == 5 && d == 5)) continue; //regles BORDS
-					if (g == 0 && c == 0 && d == 0) continue;
-					if (g == 1 && c == 1 && d == 1) continue;
-					if (g == 5 && c == 0 && d == 0) continue;
-					if (g == 0 && c == 0 && d == 5) continue;
-					if (g == 5 && c == 1 && d == 1) continue;
-					if (g == 1 && c == 1 && d == 0) continue;
-					if (g == 5 && c == 1 && d == 0) continue;
-					if (g == 1 && c == 0 && d == 5) continue;
-					//std::cout << "|||" << indexVal(g,c,d) << "|||" ;
-					res.push_back(indexVal(g,c,d));					
-				}
-			}
-		}
-			
-			//std::cout<<"blyat" << res.size() << "fin de blyat";
-			
 
-		
-		return res;
-	}
-		void setRandomRules(){
-			
-			for (int i = 0 ; i <  216 ; i++){
-				rules[i] = rand() % 4;
-			} 
-			
-			
-			setFixedRules();
-		}
-		
-		void setFixedRules(){
-			//000 => 0
-			indices[indexVal(0,0,0)] = 0 ;
-			//111 => 4
-			indices[indexVal(1,1,1)] = 4 ;
-			//B00 => 0
-			indices[indexVal(5,0,0)] = 0;
-			//00B => 0
-			indices[indexVal(0,0,5)] = 0;
-			//B11 => 4
-			indices[indexVal(5,1,1)] = 4;
-			//11B => 4
-			indices[indexVal(1,1,0)] = 4;
-			//B10 => 1
-			indices[indexVal(5,1,0)] = 1;
-			//10B => 1
-			indices[indexVal(1,0,5)] = 1;
-		}
+  // random key of the value of a rule: output number (16 i + value) of splitmix64
+  static uint64_t key(unsigned i, int value) {
+    uint64_t z = ((((uint64_t) i << 4) | (uint64_t) value) + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
   
   
+  /*
+    Canonical form of the solution, written in form (nbRules values),
+    the rules of the solution are not modified:
+      - the useful rules which are not read by the evaluation
+        (sizes 2 to fitness() + 1, see Automata::eval) are UNUSED,
+      - the free states (see RuleTables::isFree) are permuted such that
+        the vector of rules is the smallest one (lexicographic order).
+    Two solutions with the same behavior until the size fitness() + 1 have the same canonical form.
+    The fitness has to be computed.
+  */
+  void canonicalForm(uint8_t * form) const {
+    std::copy(rules, rules + nbRules, form);
+
+    if (invalid()) {
+      std::cerr << "canonicalForm: the fitness of the solution is not computed." << std::endl;
+      return;
+    }
+
+    bool read[nbRules];
+    for(unsigned i = 0; i < nbRules; i++)
+      read[i] = false;
+
+    for(int n = 2; n <= fitnessValue + 1; n++)
+      readRules(n, read);
+
+    for(int k = 0; k < S::tables.nbUseful; k++)
+      if (!read[S::tables.useful[k]])
+        form[S::tables.useful[k]] = UNUSED;
+
+    // permutations of the free states
+    int p[S::nbDigits];
+    std::vector<int> free;
+    for(int s = 0; s < S::nbDigits; s++) {
+      p[s] = s;
+      if (S::isFree(s))
+        free.push_back(s);
+    }
+
+    uint8_t permuted[nbRules];
+    uint8_t unpermuted[nbRules];
+    std::copy(form, form + nbRules, unpermuted);
+
+    std::vector<int> image(free);
+    while (std::next_permutation(image.begin(), image.end())) {
+      for(unsigned k = 0; k < free.size(); k++)
+        p[free[k]] = image[k];
+
+      for(unsigned i = 0; i < nbRules; i++) {
+        int d = i % S::nbDigits;
+        int j = i / S::nbDigits;
+        int c = j % S::nbDigits;
+        int g = j / S::nbDigits;
+        int v = unpermuted[i];
+
+        permuted[S::index(p[g], p[c], p[d])] = (v < S::nbDigits) ? p[v] : v;
+      }
+
+      if (std::lexicographical_compare(permuted, permuted + nbRules, form, form + nbRules))
+        std::copy(permuted, permuted + nbRules, form);
+    }
+  }
+
+  // Zobrist hash of the canonical form (see canonicalForm)
+  uint64_t canonicalHash() const {
+    uint8_t form[nbRules];
+    canonicalForm(form);
+
+    uint64_t h = 0;
+    for(unsigned i = 0; i < nbRules; i++)
+      h ^= key(i, form[i]);
+    return h;
+  }
+
+  /*
+    The rules become the canonical form (see canonicalForm) where the UNUSED rules are REPOS:
+    the solution can still be evaluated, with the same fitness (the rules set to REPOS
+    are not read until the size fitness() + 1 which breaks the solution).
+  */
+  void canonicalize() {
+    if (invalid()) {
+      std::cerr << "canonicalize: the fitness of the solution is not computed." << std::endl;
+      return;
+    }
+
+    canonicalForm(rules);
+
+    for(int k = 0; k < S::tables.nbUseful; k++)
+      if (rules[S::tables.useful[k]] == UNUSED)
+        rules[S::tables.useful[k]] = REPOS;
+
+    rehash();
+  }
+
   int fitness() const {
     return fitnessValue;
   }
@@ -193,31 +280,10 @@ public:
       _os << fitnessValue << ' ';
     }
 
-    // becareful, work only for 5 or 6 states, sorry...
-    int nbStates;
-    if (nbRules == 216)
-      nbStates = 5;
-    else
-      nbStates = 6;
-
-    unsigned nbDigits = nbStates + 1; // nbStates + BORDER
-    int FIRE   = nbStates - 1;
-    int BORD   = nbStates;
-    int UNUSED = 8;
-
-    int g, c, d, j;
-    for(int i = 0; i < nbRules; i++) {
-      d = i % nbDigits;
-      j = i / nbDigits;
-      c = j % nbDigits;
-      g = j / nbDigits;
-      
-      if ( (g < FIRE && c < FIRE && d < FIRE) ||
-              (g == BORD && c < FIRE && d < FIRE) ||
-              (g < FIRE && c < FIRE && d == BORD) 
-          )
-        if (rules[i] != UNUSED)
-          _os << rules[i] ;
+    // UNUSED is written 8 (see readFrom)
+    for(unsigned i = 0; i < nbRules; i++) {
+      if (S::tables.possible[i])
+        _os << (int) rules[i] ;
     }
   }
 
@@ -241,36 +307,15 @@ void readFrom(std::istream & _in) {
   std::string v;
   _in >> v;
 
-  // BECAREFULL only work for 5 or 6 states !!!!
-  int nbStates;
-  if (v.size() == 96) { // 96 = 4^3 + 2 * 4^2
-    nbStates = 5; 
-  } else {
-    if (v.size() == 175) // 175 = 5^3 + 2 * 5^2
-      nbStates = 6;
-    else
-      std::cerr << "readFrom: unknown number of states (should be 5 or 6)." << std::endl;
+  // 96 = 4^3 + 2 * 4^2 for 5 states, 175 = 5^3 + 2 * 5^2 for 6 states
+  if (v.size() != (unsigned) S::tables.nbPossible) {
+    std::cerr << "readFrom: wrong number of rules for " << nbStates << " states." << std::endl;
+    return;
   }
 
-  if (rules == NULL)
-    rules = new int[nbRules];
-
-  unsigned nbDigits = nbStates + 1; // nbStates + BORDER
-  int FIRE = nbStates - 1;
-  int BORD = nbStates;
-
-  int value;
-  int g, c, d, j, k;
-  k = 0;
+  int k = 0;
   for(unsigned i = 0; i < nbRules; i++) {
-    d = i % nbDigits;
-    j = i / nbDigits;
-    c = j % nbDigits;
-    g = j / nbDigits;
-    
-    if ( (g < FIRE && c < FIRE && d < FIRE) ||
-        (g == BORD && c < FIRE && d < FIRE) ||
-        (g < FIRE && c < FIRE && d == BORD) ) {
+    if (S::tables.possible[i]) {
       rules[i] = v[k] - '0' ;
       //cout << v[k] << "," << rules[i] << " " ;
       k++;
@@ -279,6 +324,8 @@ void readFrom(std::istream & _in) {
     //      cout << rules[i] << " " ;
   }
 
+  rehash();
+
 }
 
   /*
@@ -286,41 +333,64 @@ void readFrom(std::istream & _in) {
     leftState centerState rightState newCenterState
   */
   void printOnFull(std::ostream& _os) const {
-    // becareful, work only for 5 or 6 states, sorry...
-    int nbStates;
-    if (nbRules == 216)
-      nbStates = 5;
-    else
-      nbStates = 6;
-
-    unsigned nbDigits = nbStates + 1; // nbStates + BORDER
-    int FIRE = nbStates - 1;
-    int BORD = nbStates;
-    int UNUSED = 8;
-    
     int g, c, d, j;
-    for(int i = 0; i < nbRules; i++) {
-      d = i % nbDigits;
-      j = i / nbDigits;
-      c = j % nbDigits;
-      g = j / nbDigits;
+    for(unsigned i = 0; i < nbRules; i++) {
+      d = i % S::nbDigits;
+      j = i / S::nbDigits;
+      c = j % S::nbDigits;
+      g = j / S::nbDigits;
       
-      if ( (g < FIRE && c < FIRE && d < FIRE) ||
-              (g == BORD && c < FIRE && d < FIRE) ||
-              (g < FIRE && c < FIRE && d == BORD) 
-          )
+      if (S::tables.possible[i])
         if (rules[i] != UNUSED)
-          _os << g << " " << c << " " << d << " " << rules[i] << std::endl;
+          _os << g << " " << c << " " << d << " " << (int) rules[i] << std::endl;
     }
   }
 
 protected:
+  /*
+    mark the rules read by the evolution of the size n, until the row of the first firing
+    (the simulation of the size stops at an UNUSED rule)
+  */
+  void readRules(int n, bool * read) const {
+    std::vector<uint8_t> prev(n, REPOS), cur(n, REPOS);
+    int g, c, d, r, last;
+    bool fire = false;
+
+    prev[0] = GEN;
+    for(int t = 1; t <= 2 * n - 2 && !fire; t++) {
+      last = (t < n - 1) ? t : n - 1;
+
+      for(int i = 0; i <= last; i++) {
+        g = (i == 0) ? S::BORD : prev[i - 1];
+        c = prev[i];
+        d = (i == n - 1) ? S::BORD : prev[i + 1];
+
+        r = S::index(g, c, d);
+        read[r] = true;
+        if (rules[r] == UNUSED)
+          return;
+
+        cur[i] = rules[r];
+        fire = fire || (cur[i] == S::FIRE);
+      }
+
+      prev.swap(cur);
+    }
+  }
+
   int fitnessValue;
   bool invalidValue;
 
+  // Zobrist hash of the rules (see hash)
+  uint64_t hashValue;
+
 };
 
-std::ostream & operator<<(std::ostream& _os, const Solution & _solution) {
+template <int NbStates>
+const RuleIndexList Solution<NbStates>::indices = { States<NbStates>::tables.useful, States<NbStates>::tables.nbUseful };
+
+template <int NbStates>
+std::ostream & operator<<(std::ostream& _os, const Solution<NbStates> & _solution) {
   _solution.printOn(_os);
   return _os;
 }
@@ -0,0 +1,140 @@
+/*
+  states.h
+
+  Firing Squad Synhronization Problem:
+     States of the cellular automata, and tables of the rules
+     computed at compile time for a given number of states (5 or 6).
+
+     A rule is the new state of the center cell of a neighborhood (g, c, d)
+     where g, c, d are states or the border BORD.
+     The index of the rule (g, c, d) is g * nbDigits^2 + c * nbDigits + d.
+*/
+
+#ifndef __states__h
+#define __states__h
+
+// Notation for states (whatever the number of states)
+const int REPOS = 0;
+const int GEN = 1;
+const int NONGEN = 2;
+const int NONGENBIS = 3;
+
+const int UNUSED = 8;
+const int IMPOSSIBLE = 9;
+
+/*********************************************
+ * tables of the rules, computed at compile time
+ *
+ *********************************************/
+template <int NbStates>
+struct RuleTables {
+  static const int nbDigits  = NbStates + 1; // nbStates + BORDER
+  static const int nbDigits2 = nbDigits * nbDigits;
+  static const int nbRules   = nbDigits * nbDigits2;
+
+  static const int FIRE = NbStates - 1;
+  static const int BORD = NbStates;
+
+  // state of the 2 cells of the size 2 at time 1 (see Automata::createTrace)
+  static const int TRACE = (NbStates == 5) ? GEN : NONGEN;
+
+  // possible[i] : the rule i can be used (no impossible neighborhood)
+  bool possible[nbRules];
+
+  // fixed[i] : value of the fixed rule i, -1 when the rule is not fixed
+  int fixed[nbRules];
+
+  // useful[k] : index of the k-th useful rule, i.e. the rules modified by the searches:
+  //             possible, not fixed, without firing cell, center is not the border
+  int useful[nbRules];
+  int nbUseful;
+
+  // number of possible rules (size of the compact format)
+  int nbPossible;
+
+  constexpr RuleTables() : possible(), fixed(), useful(), nbUseful(0), nbPossible(0) {
+    int g = 0, c = 0, d = 0, j = 0;
+
+    for(int i = 0; i < nbRules; i++) {
+      d = i % nbDigits;
+      j = i / nbDigits;
+      c = j % nbDigits;
+      g = j / nbDigits;
+
+      possible[i] = (g < FIRE && c < FIRE && d < FIRE) ||
+                    (g == BORD && c < FIRE && d < FIRE) ||
+                    (g < FIRE && c < FIRE && d == BORD);
+      if (possible[i])
+        nbPossible++;
+
+      fixed[i] = -1;
+    }
+
+    // quiescence: 000 => 0, B00 => 0, 00B => 0
+    fixed[index(REPOS, REPOS, REPOS)] = REPOS;
+    fixed[index(BORD, REPOS, REPOS)]  = REPOS;
+    fixed[index(REPOS, REPOS, BORD)]  = REPOS;
+
+    // size 2: B10 => T, 10B => T, then BTT => F, TTB => F (and TTT => F)
+    fixed[index(BORD, GEN, REPOS)]    = TRACE;
+    fixed[index(GEN, REPOS, BORD)]    = TRACE;
+    fixed[index(BORD, TRACE, TRACE)]  = FIRE;
+    fixed[index(TRACE, TRACE, BORD)]  = FIRE;
+    fixed[index(TRACE, TRACE, TRACE)] = FIRE;
+
+    for(int i = 0; i < nbRules; i++) {
+      d = i % nbDigits;
+      j = i / nbDigits;
+      c = j % nbDigits;
+      g = j / nbDigits;
+
+      if (possible[i] && fixed[i] < 0 && g != FIRE && c != FIRE && d != FIRE && c != BORD)
+        useful[nbUseful++] = i;
+    }
+  }
+
+  static constexpr int index(int g, int c, int d) {
+    return g * nbDigits2 + c * nbDigits + d;
+  }
+
+  // free state: not used by the fixed rules, the free states can be permuted
+  // without changing the automata (NONGEN and NONGENBIS for 5 states, NONGENBIS and 4 for 6 states)
+  static constexpr bool isFree(int s) {
+    return s != REPOS && s != GEN && s != TRACE && s < FIRE;
+  }
+};
+
+/*********************************************
+ * states and rules for a given number of states
+ *
+ *********************************************/
+template <int NbStates>
+struct States {
+  static const int nbStates  = NbStates;
+
+  // number of digit (including border)
+  static const int nbDigits  = RuleTables<NbStates>::nbDigits;
+  static const int nbDigits2 = RuleTables<NbStates>::nbDigits2;
+
+  // dimension of the tabular of the rules
+  static const int nbRules   = RuleTables<NbStates>::nbRules; // = 6^3 = 216 for 5 states
+
+  static const int FIRE  = RuleTables<NbStates>::FIRE;
+  static const int BORD  = RuleTables<NbStates>::BORD;
+  static const int TRACE = RuleTables<NbStates>::TRACE;
+
+  static constexpr RuleTables<NbStates> tables = RuleTables<NbStates>();
+
+  static constexpr int index(int g, int c, int d) {
+    return RuleTables<NbStates>::index(g, c, d);
+  }
+
+  static constexpr bool isFree(int s) {
+    return RuleTables<NbStates>::isFree(s);
+  }
+};
+
+template <int NbStates>
+constexpr RuleTables<NbStates> States<NbStates>::tables;
+
+#endif
@@ -0,0 +1,141 @@
+/*
+  threadPool.h
+
+  Firing Squad Synhronization Problem:
+     Pool of threads to run a set of tasks in parallel.
+     The threads are created once, the caller thread is the thread 0.
+*/
+
+#ifndef __threadPool__h
+#define __threadPool__h
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+  /*********************************************
+   * constructor
+   *
+   * input : nbThreads : number of threads (including the caller thread),
+   *                     0 for the number of cores
+   *
+   *********************************************/
+  ThreadPool(int _nbThreads = 0) : nbThreads(_nbThreads), generation(0), running(0), stop(false) {
+    if (nbThreads <= 0)
+      nbThreads = std::thread::hardware_concurrency();
+    if (nbThreads <= 0)
+      nbThreads = 1;
+
+    for(int i = 1; i < nbThreads; i++)
+      threads.push_back(std::thread(&ThreadPool::loop, this, i));
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    start.notify_all();
+
+    for(unsigned i = 0; i < threads.size(); i++)
+      threads[i].join();
+  }
+
+  int size() const {
+    return nbThreads;
+  }
+
+  /*********************************************
+   * run the tasks 0 to nbTasks-1, and wait the end of all of them
+   *
+   * input : nbTasks : number of tasks
+   *         f : function called by f(thread, task)
+   *
+   *********************************************/
+  template <class F>
+  void run(int _nbTasks, F & f) {
+    call = &callFunction<F>;
+    context = &f;
+    nbTasks = _nbTasks;
+    next = 0;
+
+    if (nbThreads > 1) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = nbThreads - 1;
+        generation++;
+      }
+      start.notify_all();
+    }
+
+    work(0);
+
+    if (nbThreads > 1) {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (running > 0)
+        done.wait(lock);
+    }
+  }
+
+private:
+  int nbThreads;
+
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable start;
+  std::condition_variable done;
+
+  // number of runs, number of threads still running, end of the pool
+  unsigned generation;
+  int running;
+  bool stop;
+
+  // current run: next task to execute, and function to call
+  std::atomic<int> next;
+  int nbTasks;
+  void (*call)(void *, int, int);
+  void * context;
+
+  template <class F>
+  static void callFunction(void * f, int thread, int task) {
+    (*static_cast<F*>(f))(thread, task);
+  }
+
+  void work(int thread) {
+    int task;
+
+    while ((task = next.fetch_add(1)) < nbTasks)
+      call(context, thread, task);
+  }
+
+  void loop(int thread) {
+    unsigned seen = 0;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stop && generation == seen)
+          start.wait(lock);
+        if (stop)
+          return;
+        seen = generation;
+      }
+
+      work(thread);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+        if (running == 0)
+          done.notify_one();
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*
+  bench-eval.cpp
+
+  Firing Squad Synhronization Problem:
+    benchmark of the evaluation
+
+    For each maximum size of the automata (30, 100, 500, 2000),
+    measure the throughput of:
+      - eval of the solution of the file, and of random rules
+      - verify (evolution from scratch of the size maxSize with two rows) of the same rules
+      - the hill climber (incremental evaluation), with the mutations of all the useful rules,
+        and only of the rules used by the incumbent
+    Each measure has a warmup, then the mean, standard deviation and minimum
+    over the repetitions of evaluations/second, cell-updates/second and ns/cell.
+    With FSSP_COUNTERS, the counters of the evaluation (of all the threads) are printed in JSON at the end.
+
+    The rows are vectorized with the best instruction set of the processor (see RowKernel),
+    or at most the given one (0: scalar, 1: ssse3, 2: avx2, 3: avx512).
+
+    usage: ./bench-eval [repetitions [seconds by repetition [instruction set]]]
+*/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+// number of states
+const int nbStates = 5;
+
+// number of repetitions of each measure, and minimum duration of a repetition (seconds)
+int nbRepetitions = 10;
+double duration = 0.05;
+
+/*********************************************
+ * mean, standard deviation and minimum of values
+ *
+ *********************************************/
+struct Statistics {
+  double mean, sd, min;
+
+  Statistics(const std::vector<double> & v) {
+    mean = 0;
+    min = v[0];
+    for(unsigned i = 0; i < v.size(); i++) {
+      mean += v[i];
+      if (v[i] < min)
+        min = v[i];
+    }
+    mean /= v.size();
+
+    sd = 0;
+    for(unsigned i = 0; i < v.size(); i++)
+      sd += (v[i] - mean) * (v[i] - mean);
+    sd = (v.size() > 1) ? sqrt(sd / (v.size() - 1)) : 0;
+  }
+};
+
+/*********************************************
+ * measure of a benchmark
+ *
+ * input : name : name of the benchmark
+ *         maxSize : maximum size of the automata
+ *         f : one evaluation, f(nbCells) adds the number of computed cells to nbCells
+ *
+ *********************************************/
+template <class F>
+void measure(const char * name, int maxSize, F f) {
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<double> evals, cells, ns;
+  uint64_t nbEvals, nbCells;
+  double seconds;
+
+  // warmup, then the repetitions
+  for(int r = -1; r < nbRepetitions; r++) {
+    nbEvals = 0;
+    nbCells = 0;
+
+    Clock::time_point start = Clock::now();
+    do {
+      f(nbCells);
+      nbEvals++;
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < duration);
+
+    if (r >= 0) {
+      evals.push_back(nbEvals / seconds);
+      cells.push_back(nbCells / seconds);
+      ns.push_back(1e9 * seconds / nbCells);
+    }
+  }
+
+  Statistics e(evals), c(cells), n(ns);
+
+  std::cout << std::setw(7) << maxSize << "  " << std::left << std::setw(20) << name << std::right
+            << std::scientific << std::setprecision(3)
+            << std::setw(12) << e.mean << " +- " << std::setw(9) << e.sd
+            << std::setw(12) << c.mean << " +- " << std::setw(9) << c.sd
+            << std::fixed << std::setprecision(3)
+            << std::setw(9) << n.mean << " +- " << std::setw(6) << n.sd << " (min " << n.min << ")"
+            << std::endl;
+}
+
+int main(int argc, char ** argv) {
+    if (argc > 1)
+      nbRepetitions = atoi(argv[1]);
+    if (argc > 2)
+      duration = atof(argv[2]);
+    if (argc > 3)
+      RowKernel<nbStates>::setLevel(atoi(argv[3]));
+
+    std::cout << "rows: " << RowKernel<nbStates>::name(RowKernel<nbStates>::level()) << std::endl;
+
+    // solution of the file
+    Solution<nbStates> x;
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    // random rules
+    Random rngRules(1);
+    std::vector< Solution<nbStates> > randoms(256);
+    for(unsigned i = 0; i < randoms.size(); i++)
+      randoms[i].setRandomRules(rngRules);
+
+    std::cout << "maxSize  benchmark                 evals/s (+- sd)          cells/s (+- sd)       ns/cell (+- sd)" << std::endl;
+
+    int sizes[] = { 30, 100, 500, 2000 };
+
+    for(int s = 0; s < 4; s++) {
+      int maxSize = sizes[s];
+      Automata<nbStates> ca(maxSize);
+      unsigned next = 0;
+
+      measure("eval file", maxSize, [&](uint64_t & nbCells) {
+        ca.resetCellUpdates();
+        ca.eval(x, maxSize - 1);
+        nbCells += ca.cellUpdates();
+      });
+
+      measure("eval random", maxSize, [&](uint64_t & nbCells) {
+        ca.resetCellUpdates();
+        ca.eval(randoms[next++ % randoms.size()], maxSize - 1);
+        nbCells += ca.cellUpdates();
+      });
+
+      measure("verify file", maxSize, [&](uint64_t & nbCells) {
+        Automata<nbStates>::verify(x, maxSize, nbCells);
+      });
+
+      measure("verify random", maxSize, [&](uint64_t & nbCells) {
+        Automata<nbStates>::verify(randoms[next++ % randoms.size()], maxSize, nbCells);
+      });
+
+      // one evaluation is 1000 iterations of the hill climber
+      Random rng(1);
+      Solution<nbStates> y(x);
+      measure("hill climber x1000", maxSize, [&](uint64_t & nbCells) {
+        ca.resetCellUpdates();
+        ca.hillClimberFirst(y, maxSize - 1, 1000, rng);
+        nbCells += ca.cellUpdates();
+      });
+
+      // mutations only on the rules used by the incumbent (see Automata::setUsedRulesOnly)
+      Random rngUsed(1);
+      Solution<nbStates> z(x);
+      ca.setUsedRulesOnly(true);
+      ca.resetRedrawnMutations();
+      measure("hill climber used", maxSize, [&](uint64_t & nbCells) {
+        ca.resetCellUpdates();
+        ca.hillClimberFirst(z, maxSize - 1, 1000, rngUsed);
+        nbCells += ca.cellUpdates();
+      });
+      std::cout << "         mutations of unused rules redrawn: " << ca.redrawnMutations() << std::endl;
+      ca.setUsedRulesOnly(false);
+    }
+
+    // counters of the evaluation (cmake -DFSSP_COUNTERS=ON)
+    FSSP_COUNT(allEvalCounters().printJSON(std::cout); std::cout << std::endl;)
+}
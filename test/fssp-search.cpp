@@ -0,0 +1,274 @@
+/*
+  fssp-search.cpp
+
+  Firing Squad Synhronization Problem:
+    search driver with a time budget
+
+    Run a search of Automata (marcheAleatoire, hillClimberFirst or iteratedLocalSearch)
+    from a solution file or from random rules, until the time budget is spent
+    (or SIGINT / SIGTERM, see Automata::setStop), and write the best solution.
+    The best fitness and the throughput are reported while it runs:
+    evaluated solutions/s (see Automata::evaluations, the mutations redrawn by --used
+    are not counted) and computed cells/s.
+
+    usage: ./fssp-search [options]
+      --states n        number of states: 5 or 6 (default 5)
+      --nmax n          maximum size of the firing squad (default 30)
+      --algo a          walk, hc (first improvement) or ils (default ils)
+      --strength n      number of rules modified by the perturbation of ils (default 10)
+      --hc-iter n       iterations of the hill climber in each step of ils (default 10000)
+      --used            mutations of the rules used by the incumbent only (see setUsedRulesOnly)
+      --threads n       threads of the evaluation, 0 for the number of cores (default 1)
+      --speculation n   mutations evaluated in parallel by the hill climber (default: 2 by thread)
+      --cache n         cache of the fitness values with 2^n slots, 0 for no cache (default 0)
+      --time s          time budget in seconds (default 60)
+      --report s        time between two reports in seconds (default 1)
+      --seed n          seed of the random generator (default: time)
+      --in file         initial solution (default: random rules)
+      --out file        best solution (default: printed only)
+
+    example: ./fssp-search --nmax 30 --algo ils --time 10 --in ../solution/solution_5.dat --out best.dat
+*/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <climits>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/checkpoint.h>
+#include <base/fitnessCache.h>
+
+struct Options {
+  int states = 5;
+  int nMax = 30;
+  std::string algorithm = "ils";
+  int strength = 10;
+  int hcIter = 10000;
+  bool usedRulesOnly = false;
+  int threads = 1;
+  int speculation = -1;
+  int cache = 0;
+  double budget = 60;
+  double report = 1;
+  uint64_t seed = time(NULL);
+  std::string in;
+  std::string out;
+};
+
+/*********************************************
+ * search with NbStates states
+ *
+ * output : 0 when the search is done, 1 when the initial solution is not read
+ *
+ *********************************************/
+template <int NbStates>
+int search(const Options & options) {
+  typedef std::chrono::steady_clock Clock;
+
+  Automata<NbStates> ca(options.nMax + 2);
+  Random rng(options.seed);
+
+  ca.setUsedRulesOnly(options.usedRulesOnly);
+  ca.setNbThreads(options.threads);
+  if (options.speculation >= 0)
+    ca.setSpeculation(options.speculation);
+  else if (options.threads != 1)
+    ca.setSpeculation(2 * (options.threads > 0 ? options.threads : std::thread::hardware_concurrency()));
+
+  FitnessCache * cache = NULL;
+  if (options.cache > 0) {
+    cache = new FitnessCache(options.nMax, options.cache);
+    ca.setCache(cache);
+  }
+
+  Solution<NbStates> current;
+  if (options.in.empty())
+    current.setRandomRules(rng);
+  else {
+    std::fstream filein(options.in.c_str(), std::ios::in);
+    if (!filein) {
+      std::cerr << "fssp-search: impossible to open " << options.in << std::endl;
+      return 1;
+    }
+    current.readFrom(filein);
+    filein.close();
+  }
+
+  ca.eval(current, options.nMax);
+  Solution<NbStates> best(current);
+
+  std::cout << "states " << NbStates << "  nMax " << options.nMax << "  algorithm " << options.algorithm
+            << "  seed " << options.seed << "  budget " << options.budget << "s" << std::endl;
+  std::cout << "initial fitness " << current.fitness() << std::endl;
+  std::cout << "    time(s)  best  current        evals/s        cells/s" << std::endl;
+
+  ca.resetEvaluations();
+  ca.resetCellUpdates();
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point lastReport = start;
+  uint64_t lastEvaluations = 0;
+  uint64_t lastCells = 0;
+  int currentFitness = current.fitness();
+
+  auto elapsed = [&]() {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  };
+
+  // report of the best fitness and of the throughput since the last report
+  auto report = [&](bool force) {
+    Clock::time_point now = Clock::now();
+    double period = std::chrono::duration<double>(now - lastReport).count();
+
+    if (!force && period < options.report)
+      return;
+
+    uint64_t evaluations = ca.evaluations();
+    uint64_t cells = ca.cellUpdates();
+    std::cout << std::setw(11) << std::fixed << std::setprecision(1) << elapsed()
+              << std::setw(6) << best.fitness() << std::setw(9) << currentFitness
+              << std::scientific << std::setprecision(3)
+              << std::setw(15) << (period > 0 ? (evaluations - lastEvaluations) / period : 0)
+              << std::setw(15) << (period > 0 ? (cells - lastCells) / period : 0)
+              << std::defaultfloat << std::endl;
+
+    lastReport = now;
+    lastEvaluations = evaluations;
+    lastCells = cells;
+  };
+
+  // called periodically by the search with its current solution (see Automata::setStop):
+  // best solution, report, and stop at the end of the time budget or on a signal
+  ca.setStop([&](const Solution<NbStates> & x) {
+    currentFitness = x.fitness();
+    if (x.fitness() > best.fitness())
+      best = x;
+    report(false);
+    return elapsed() >= options.budget || Checkpoint<NbStates>::stopRequested();
+  });
+
+  Checkpoint<NbStates>::clearStop();
+  Checkpoint<NbStates>::catchSignals(true);
+
+  // the searches run until the stop function returns true
+  if (options.algorithm == "walk")
+    ca.marcheAleatoire(current, options.nMax, INT_MAX, rng);
+  else if (options.algorithm == "hc")
+    ca.hillClimberFirst(current, options.nMax, INT_MAX, rng);
+  else {
+    ca.setIteratedLocalSearch(options.strength, options.hcIter);
+    ca.iteratedLocalSearch(current, options.nMax, INT_MAX, rng);
+  }
+
+  Checkpoint<NbStates>::catchSignals(false);
+  ca.setStop(nullptr);
+
+  currentFitness = current.fitness();
+  if (current.fitness() > best.fitness())
+    best = current;
+
+  if (ca.evaluations() > lastEvaluations)
+    report(true);
+  uint64_t nbEvaluations = ca.evaluations();
+  std::cout << nbEvaluations << " evaluations in " << elapsed() << "s: "
+            << nbEvaluations / elapsed() << " evals/s" << std::endl;
+  if (cache != NULL) {
+    std::cout << "cache: ";
+    cache->printOn(std::cout);
+    std::cout << std::endl;
+  }
+  std::cout << "best" << std::endl << best << std::endl;
+
+  if (!options.out.empty()) {
+    std::fstream fileout(options.out.c_str(), std::ios::out);
+    fileout << best << std::endl;
+    if (!fileout)
+      std::cerr << "fssp-search: impossible to write " << options.out << std::endl;
+  }
+
+  ca.setCache(NULL);
+  delete cache;
+
+  return 0;
+}
+
+void usage() {
+  std::cerr << "usage: ./fssp-search [--states 5|6] [--nmax n] [--algo walk|hc|ils] [--strength n] [--hc-iter n] [--used]" << std::endl
+            << "                     [--threads n] [--speculation n] [--cache n] [--time s] [--report s] [--seed n] [--in file] [--out file]" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+  Options options;
+
+  for(int i = 1; i < argc; i++) {
+    std::string name = argv[i];
+
+    if (name == "--used") {
+      options.usedRulesOnly = true;
+      continue;
+    }
+
+    if (i + 1 >= argc) {
+      usage();
+      return 1;
+    }
+    const char * value = argv[++i];
+
+    if (name == "--states")
+      options.states = atoi(value);
+    else if (name == "--nmax")
+      options.nMax = atoi(value);
+    else if (name == "--algo")
+      options.algorithm = value;
+    else if (name == "--strength")
+      options.strength = atoi(value);
+    else if (name == "--hc-iter")
+      options.hcIter = atoi(value);
+    else if (name == "--threads")
+      options.threads = atoi(value);
+    else if (name == "--speculation")
+      options.speculation = atoi(value);
+    else if (name == "--cache")
+      options.cache = atoi(value);
+    else if (name == "--time")
+      options.budget = atof(value);
+    else if (name == "--report")
+      options.report = atof(value);
+    else if (name == "--seed")
+      options.seed = strtoull(value, NULL, 10);
+    else if (name == "--in")
+      options.in = value;
+    else if (name == "--out")
+      options.out = value;
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  if (options.algorithm != "walk" && options.algorithm != "hc" && options.algorithm != "ils") {
+    std::cerr << "fssp-search: unknown algorithm " << options.algorithm << std::endl;
+    usage();
+    return 1;
+  }
+
+  if (options.nMax < 3 || options.hcIter < 1 || options.strength < 0 || options.cache < 0 || options.cache > 30) {
+    usage();
+    return 1;
+  }
+
+  if (options.states == 5)
+    return search<5>(options);
+  if (options.states == 6)
+    return search<6>(options);
+
+  std::cerr << "fssp-search: " << options.states << " states are not supported (5 or 6)" << std::endl;
+  return 1;
+}
@@ -0,0 +1,63 @@
+/*
+  t-archive.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example for the binary archive of solutions
+
+    Append solutions to an archive
+    Read the archive (memory map), and compare the solutions
+*/
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/archive.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    Automata<nbStates> ca(30);
+
+    // the solution of the file, and random solutions
+    std::vector< Solution<nbStates> > solutions(1000);
+
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    solutions[0].readFrom(filein);
+    filein.close();
+
+    Random rng(1);
+    for(unsigned i = 1; i < solutions.size(); i++)
+      solutions[i].setRandomRules(rng);
+
+    for(unsigned i = 0; i < solutions.size(); i++)
+      ca.eval(solutions[i], 29);
+
+    // append to a new archive
+    const char * fileName = "solutions.fssp";
+    remove(fileName);
+
+    ArchiveWriter<nbStates> writer(fileName);
+    for(unsigned i = 0; i < solutions.size(); i++)
+      writer.append(solutions[i]);
+
+    // read the archive
+    ArchiveReader<nbStates> reader(fileName);
+    std::cout << reader.size() << " records" << std::endl;
+
+    Solution<nbStates> x;
+    int nbErrors = 0;
+    for(size_t i = 0; i < reader.size(); i++) {
+      if (!reader[i].get(x) || x.fitness() != solutions[i].fitness())
+        nbErrors++;
+    }
+
+    // expected value 0
+    std::cout << nbErrors << " errors" << std::endl;
+
+    reader[0].get(x);
+    std::cout << x << std::endl;
+}
@@ -0,0 +1,63 @@
+/*
+  t-backtracking.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the exact search with a partial table of rules
+
+    Search the first solution which synchronizes the sizes 2 to 9, and its canonical form
+    Count all the solutions of the sizes 2 to 4 with the threads of the machine
+*/
+
+#include <iostream>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/backtracking.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // first solution of the sizes 2 to 9
+    int nMax = 9;
+    Solution<nbStates> x;
+    auto first = [&](const Solution<nbStates> & s) {
+      x = s;
+      return false; // stop the search
+    };
+
+    Backtracking<nbStates> search(nMax);
+    search.search(first);
+
+    std::cout << "first solution (" << search.nodes() << " nodes): " << x << std::endl;
+
+    // the rules not used until the size nMax are UNUSED: set to REPOS, then evaluation
+    for(unsigned i = 0; i < x.nbRules; i++)
+      if (x.rules[i] == UNUSED)
+        x.rules[i] = REPOS;
+    x.rehash();
+
+    Automata<nbStates> ca(30);
+    ca.eval(x, 20);
+    std::cout << "fitness with the unused rules set to REPOS: " << x.fitness() << std::endl;
+
+    // canonical form: the rules not read until the size fitness+1 are REPOS,
+    // the canonical solution has the same fitness, and the same canonical hash
+    Solution<nbStates> y(x);
+    y.canonicalize();
+    ca.eval(y, 20);
+    std::cout << "canonical form: " << y << std::endl;
+    std::cout << "same fitness: " << (y.fitness() == x.fitness() ? "yes" : "no")
+              << ", same canonical hash: " << (y.canonicalHash() == x.canonicalHash() ? "yes" : "no") << std::endl;
+
+    // all the solutions of the sizes 2 to 4 (0 : number of cores)
+    auto count = [&](const Solution<nbStates> &) {
+      return true;
+    };
+
+    Backtracking<nbStates> all(4, 0);
+    all.search(count);
+
+    // expected value 82185 (one solution by permutation of the states 2 and 3)
+    std::cout << "number of solutions of the sizes 2 to 4: " << all.solutions() << " (" << all.nodes() << " nodes)" << std::endl;
+}
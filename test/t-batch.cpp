@@ -0,0 +1,108 @@
+/*
+  t-batch.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the evaluation of a batch of 64 solutions in lockstep
+
+    For 5 and 6 states, evaluate with BatchAutomata:
+      - the solution of the file (5 states) or a solution of a hill climber (6 states),
+        and all its neighbors (one rule mutated),
+      - random rules,
+      - solutions of short hill climbers from random rules,
+    then compare the fitness of each lane with Automata::eval
+    (with the maximum sizes 0, 1, 2 and 30).
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/batchAutomata.h>
+
+/*********************************************
+ * compare the batch evaluation with Automata::eval
+ *
+ * input : x : initial solution
+ *
+ * output : number of solutions with a different fitness
+ *
+ *********************************************/
+template <int NbStates>
+int compare(const Solution<NbStates> & x, int maxSize, int nMax) {
+  const int FIRE = Automata<NbStates>::FIRE;
+
+  Automata<NbStates> ca(maxSize);
+  BatchAutomata<NbStates> batch(maxSize);
+  Random rng(1);
+
+  std::vector< Solution<NbStates> > solutions;
+
+  // the solution and its neighbors
+  solutions.push_back(x);
+  for(unsigned j = 0; j < x.indices.size(); j++)
+    for(int v = 0; v < FIRE; v++)
+      if (v != x.rules[x.indices[j]]) {
+        solutions.push_back(x);
+        solutions.back().setRule(x.indices[j], v);
+      }
+
+  // random rules, and solutions of short hill climbers
+  Solution<NbStates> y;
+  for(int k = 0; k < 100; k++) {
+    y.setRandomRules(rng);
+    solutions.push_back(y);
+    if (k % 10 == 0) {
+      ca.hillClimberFirst(y, nMax, 20000, rng);
+      solutions.push_back(y);
+    }
+  }
+
+  // the small sizes, then nMax
+  int nbDifferent = 0;
+  int maxFitness = 0;
+  for(int n : { 0, 1, 2, nMax }) {
+    std::vector< Solution<NbStates> > reference(solutions);
+    for(unsigned k = 0; k < reference.size(); k++)
+      ca.eval(reference[k], n);
+
+    batch.eval(solutions, n);
+
+    for(unsigned k = 0; k < solutions.size(); k++) {
+      if (solutions[k].fitness() != reference[k].fitness())
+        nbDifferent++;
+      if (reference[k].fitness() > maxFitness)
+        maxFitness = reference[k].fitness();
+    }
+  }
+
+  std::cout << NbStates << " states: " << solutions.size() << " solutions (best fitness " << maxFitness
+            << "), different fitness " << nbDifferent << std::endl;
+
+  return nbDifferent;
+}
+
+int main(int argc, char ** argv) {
+    int maxSize = 40;
+    int nMax = 30;
+
+    // solution of the file
+    Solution<5> x5;
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x5.readFrom(filein);
+    filein.close();
+
+    // solution of a hill climber from random rules
+    Solution<6> x6;
+    Automata<6> ca(maxSize);
+    Random rng(2);
+    x6.setRandomRules(rng);
+    ca.hillClimberFirst(x6, nMax, 100000, rng);
+
+    // expected value 0
+    int nbDifferent = compare<5>(x5, maxSize, nMax) + compare<6>(x6, maxSize, nMax);
+    std::cout << "different fitness: " << nbDifferent << std::endl;
+
+    return (nbDifferent == 0) ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+/*
+  t-cache.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the cache of the fitness values
+
+    Read a solution
+    Evaluate random rules (each one twice) with and without the cache,
+    then run the iterated local search from the same random seed with and without the cache.
+    The fitness values and the solutions are the same, the hit rate of the cache is printed.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/fitnessCache.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    int maxSize = 40;
+    int nMax = 30;
+
+    Automata<nbStates> ca(maxSize);
+    Automata<nbStates> cached(maxSize);
+    FitnessCache cache(nMax, 16);
+    cached.setCache(&cache);
+
+    // random rules, evaluated twice with the cache
+    Random rng(1);
+    Solution<nbStates> y, z;
+    int nbDifferent = 0;
+    for(int k = 0; k < 1000; k++) {
+      y.setRandomRules(rng);
+      z = y;
+      ca.eval(y, nMax);
+      for(int r = 0; r < 2; r++) {
+        cached.eval(z, nMax);
+        if (z.fitness() != y.fitness())
+          nbDifferent++;
+      }
+    }
+
+    // expected value 0
+    std::cout << "random rules: different fitness " << nbDifferent << ", cache ";
+    cache.printOn(std::cout);
+    std::cout << std::endl;
+
+    // iterated local search with and without the cache
+    std::string solutions[2];
+    for(int c = 0; c < 2; c++) {
+      Automata<nbStates> search(maxSize);
+      cache.clear();
+      if (c == 1)
+        search.setCache(&cache);
+
+      Solution<nbStates> s(x);
+      Random rngSearch(2);
+
+      auto start = std::chrono::steady_clock::now();
+      search.iteratedLocalSearch(s, nMax, 20, rngSearch);
+      double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::ostringstream os;
+      os << s;
+      solutions[c] = os.str();
+
+      std::cout << (c == 1 ? "with" : "without") << " cache: " << time << "s";
+      if (c == 1) {
+        std::cout << ", ";
+        cache.printOn(std::cout);
+      }
+      std::cout << std::endl << s << std::endl;
+    }
+
+    // expected: same
+    std::cout << "iterated local search: " << (solutions[0] == solutions[1] ? "same solution" : "DIFFERENT solutions") << std::endl;
+
+    return (nbDifferent == 0 && solutions[0] == solutions[1]) ? 0 : 1;
+}
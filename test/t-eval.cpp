@@ -6,6 +6,7 @@
 
     Create Automata
     Apply evaluation function on a solution
+    Iterated local search with checkpoints (ils.ckp)
 
 
 See for reference:
@@ -31,12 +32,12 @@ int main(int argc, char ** argv) {
     // maximum size of the cellular automata
     int maxSize = 30;
 
-    // cellular automata
-    Automata ca(maxSize);
     // number of states
-    unsigned nbStates = 5;
+    const int nbStates = 5;
+    // cellular automata
+    Automata<nbStates> ca(maxSize);
     // create an empty solution
-    Solution x(nbStates);
+    Solution<nbStates> x;
     // read from file
     std::fstream filein("../solution/solution_5.dat", std::ios::in);
     x.readFrom(filein);
@@ -51,7 +52,11 @@ int main(int argc, char ** argv) {
 	//}
     // evaluation function of the solution
     //ca.eval(x, maxSize);
-	ca.iteratedLocalSearch(x,30,100000);
+	// long search: checkpoint every minute into ils.ckp, restart from it when it is a checkpoint
+	// of the same search (nMax, maxIter, initial solution) which is not completed
+	// (ctrl-C writes the checkpoint and stops the search)
+	Random rng(time(NULL));
+	ca.iteratedLocalSearch(x,30,100000,rng,"ils.ckp",60);
 	ca.eval(x,maxSize);
 	std::cout << x << std::endl;
 	//std::cout<<" finess final : " << x.fitness();
@@ -0,0 +1,36 @@
+/*
+  t-exportRaster.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example to export the space-time diagram into raster images
+
+    Export the sizes from 2 to 30 of the solution into a PNG file (4x4 pixels by cell)
+    Export one large size into a PNG file and a PPM file (one pixel by cell)
+*/
+
+#include <iostream>
+#include <fstream>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    // all the sizes from 2 to 30
+    Automata<nbStates>::exportRaster(x, 30, "all_30.png", true, 4);
+
+    // one large size (no automata of size 2000 is allocated)
+    int N = 2000;
+    Automata<nbStates>::exportRaster(x, N, "s_2000.png");
+    Automata<nbStates>::exportRaster(x, N, "s_2000.ppm");
+}
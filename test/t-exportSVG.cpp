@@ -30,13 +30,13 @@ int main(int argc, char ** argv) {
 
     int maxSize = 30;
 
-    Automata ca(maxSize);
-
     // number of states
-    unsigned nbStates = 5;
+    const int nbStates = 5;
+
+    Automata<nbStates> ca(maxSize);
 
     // create an empty solution
-    Solution x(nbStates);
+    Solution<nbStates> x;
 
     // read from file
     std::fstream filein("../solution/solution_5.dat", std::ios::in);
@@ -53,4 +53,7 @@ int main(int argc, char ** argv) {
         sprintf(name, "s_%d.svg", i);
         ca.exportSVG(x, i, name);
     }
+
+    // same diagram with a black firing state (black and white printing)
+    ca.exportSVG(x, 6, "s_6_bw.svg", false, true);
 }
\ No newline at end of file
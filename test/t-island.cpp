@@ -0,0 +1,63 @@
+/*
+  t-island.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the island model of the iterated local search
+
+    Read a solution
+    Run the iterated local search on 4 islands (threads):
+    with a migration every iteration, then without migration.
+    The solution found is at least as fit as the initial solution.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    int maxSize = 40;
+    int nMax = 30;
+    int maxIter = 5;
+    int nbIslands = 4;
+
+    Automata<nbStates> ca(maxSize);
+    ca.eval(x, nMax);
+    std::cout << "initial fitness " << x.fitness() << std::endl;
+
+    for(int migration = 1; migration >= 0; migration--) {
+      Solution<nbStates> y(x);
+
+      auto start = std::chrono::steady_clock::now();
+      ca.islandIteratedLocalSearch(y, nMax, maxIter, nbIslands, migration, 1);
+      double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      // expected: at least the initial fitness
+      std::cout << "migration " << migration << ": " << time << "s, fitness " << y.fitness()
+                << (y.fitness() >= x.fitness() ? " (not worse)" : " (WORSE)") << std::endl;
+      std::cout << y << std::endl;
+    }
+
+    // the stop function is forwarded to the islands: all of them stop after 20 calls
+    // (instead of 1000000 iterations of each island)
+    int nbCalls = 0;
+    ca.setStop([&](const Solution<nbStates> &) {
+      return ++nbCalls >= 20;
+    });
+    Solution<nbStates> y(x);
+    ca.islandIteratedLocalSearch(y, nMax, 1000000, nbIslands, 1, 1);
+    std::cout << "stopped after " << nbCalls << " calls of the stop function, fitness " << y.fitness() << std::endl;
+}
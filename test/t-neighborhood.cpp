@@ -0,0 +1,86 @@
+/*
+  t-neighborhood.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the parallel evaluation of the neighborhood
+
+    Read a solution
+    Evaluate all its neighbors (each useful rule set to each non-firing state)
+    with evalNeighborhood, with 1 thread and with 4 threads,
+    and compare with the evaluation of each neighbor by eval.
+    Same with a solution of the hill climber.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+/*********************************************
+ * compare evalNeighborhood with eval of each neighbor
+ *
+ * output : number of neighbors with a different fitness
+ *
+ *********************************************/
+template <int NbStates>
+int compare(const Solution<NbStates> & x, int maxSize, int nMax, int nbThreads) {
+  const int FIRE = Automata<NbStates>::FIRE;
+
+  Automata<NbStates> ca(maxSize);
+  ca.setNbThreads(nbThreads);
+
+  std::vector<int> out;
+  ca.evalNeighborhood(x, nMax, out);
+
+  Automata<NbStates> reference(maxSize);
+  Solution<NbStates> y;
+  int nbDifferent = 0;
+
+  for(unsigned j = 0; j < x.indices.size(); j++)
+    for(int v = 0; v < FIRE; v++) {
+      y = x;
+      y.setRule(x.indices[j], v);
+      reference.eval(y, nMax);
+      if (out[j * FIRE + v] != y.fitness())
+        nbDifferent++;
+    }
+
+  std::cout << nbThreads << " thread(s): " << out.size() << " neighbors, different fitness " << nbDifferent << std::endl;
+
+  return nbDifferent;
+}
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    int maxSize = 40;
+    int nMax = 30;
+
+    // solution of the hill climber from the solution of the file
+    Automata<nbStates> ca(maxSize);
+    Solution<nbStates> z(x);
+    Random rng(1);
+    ca.hillClimberFirst(z, nMax, 100000, rng);
+
+    int nbDifferent = 0;
+    for(int nbThreads = 1; nbThreads <= 4; nbThreads += 3) {
+      nbDifferent += compare(x, maxSize, nMax, nbThreads);
+      nbDifferent += compare(z, maxSize, nMax, nbThreads);
+    }
+
+    // expected value 0
+    std::cout << "different fitness: " << nbDifferent << std::endl;
+
+    return (nbDifferent == 0) ? 0 : 1;
+}
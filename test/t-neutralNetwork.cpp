@@ -0,0 +1,50 @@
+/*
+  t-neutralNetwork.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the exploration of a neutral network
+
+    Read a solution
+    Explore the network of the solutions with a fitness at least 4 (breadth first),
+    with the threads of the machine and a memory budget of 4MB
+*/
+
+#include <iostream>
+#include <fstream>
+
+#include <base/solution.h>
+#include <base/automata.h>
+#include <base/neutralNetwork.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    // network of the fitness at least 4, evaluated with the sizes until 30
+    int maxSize = 40;
+    int nMax = 30;
+    int target = 4;
+    NeutralNetwork<nbStates> network(maxSize, nMax, target, 0, 64 << 20);
+
+    // number of solutions by fitness value
+    std::vector<int> histogram(nMax + 1, 0);
+    auto f = [&](const Solution<nbStates> & y) {
+      histogram[y.fitness()]++;
+      return true;
+    };
+
+    network.explore(x, f);
+
+    std::cout << network.visited() << " solutions, " << network.explored() << " explored" << (network.complete() ? "" : " (memory budget reached)") << std::endl;
+    for(int fit = target; fit <= nMax; fit++)
+      if (histogram[fit] > 0)
+        std::cout << "fitness " << fit << " : " << histogram[fit] << std::endl;
+}
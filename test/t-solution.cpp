@@ -30,10 +30,10 @@ See for reference:
 
 int main(int argc, char ** argv) {
 	// number of states
-	unsigned nbStates = 5;
+	const int nbStates = 5;
 
 	// create an empty solution
-	Solution x(nbStates);
+	Solution<nbStates> x;
 
 	// print fitness and vector of rules (compact format)
 	std::cout << x << std::endl;
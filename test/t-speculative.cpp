@@ -0,0 +1,53 @@
+/*
+  t-speculative.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example of the speculative hill climber
+
+    Read a solution
+    Run the first improvement hill climber from the same random seed:
+    sequential, then with 8 mutations evaluated in parallel by the threads of the machine.
+    The two runs give the same solution.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    int maxSize = 40;
+    int nMax = 30;
+    int maxIter = 100000;
+
+    for(int nbMoves = 1; nbMoves <= 8; nbMoves *= 8) {
+      Automata<nbStates> ca(maxSize);
+      // mutations of the used rules only: less neutral moves accepted
+      ca.setUsedRulesOnly(true);
+      ca.setNbThreads(0);
+      ca.setSpeculation(nbMoves);
+
+      Solution<nbStates> y(x);
+      Random rng(1);
+
+      auto start = std::chrono::steady_clock::now();
+      ca.hillClimberFirst(y, nMax, maxIter, rng);
+      double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << nbMoves << " move(s) by step: " << time << "s" << std::endl;
+      std::cout << y << std::endl;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  t-verify.cpp
+
+  Firing Squad Synhronization Problem:
+    test/example for the verification of large sizes
+
+    Read a solution
+    Verify the synchronization of each size with only two rows of the space-time diagram
+    Compare with the evolution of an automata allocated on the heap (vectorized rows of large sizes)
+*/
+
+#include <iostream>
+#include <fstream>
+#include <new>
+#include <vector>
+#include <stdint.h>
+
+#include <base/solution.h>
+#include <base/automata.h>
+
+int main(int argc, char ** argv) {
+    // number of states
+    const int nbStates = 5;
+
+    // create an empty solution
+    Solution<nbStates> x;
+
+    // read from file
+    std::fstream filein("../solution/solution_5.dat", std::ios::in);
+    x.readFrom(filein);
+    filein.close();
+
+    // verify the sizes from 3 to 1000 (no automata of size 1000 is allocated)
+    std::vector<bool> synchronized;
+    int last = Automata<nbStates>::verify(x, 3, 1000, synchronized);
+
+    // expected value 5
+    std::cout << "all the sizes synchronize until " << last << std::endl;
+
+    // one large size
+    int N = 5000;
+    std::cout << "size " << N << " : " << (Automata<nbStates>::verify(x, N) ? "synchronized" : "not synchronized") << std::endl;
+
+    // kernel of the rows allocated on the heap at an address which is not 64 bytes aligned
+    // (as the kernel of the Automata of the workspaces): rows of 150 centre cells
+    const int FIRE = Automata<nbStates>::FIRE;
+    char * buffer = new char[sizeof(RowKernel<nbStates>) + 64];
+    RowKernel<nbStates> * kernel = new (buffer + (80 - ((uintptr_t) buffer) % 64) % 64) RowKernel<nbStates>();
+    Random rng(1);
+    Solution<nbStates> y;
+    std::vector<uint8_t> prev(152), cur(152);
+    int nbDifferent = 0;
+    int maxLevel = RowKernel<nbStates>::level();
+    for(int level = 0; level <= maxLevel; level++) {
+      RowKernel<nbStates>::setLevel(level);
+      for(int k = 0; k < 20; k++) {
+        y.setRandomRules(rng);
+        kernel->setRules(y.rules);
+        for(unsigned i = 0; i < prev.size(); i++)
+          prev[i] = rng(FIRE);
+        int nbFire = kernel->row(prev.data(), cur.data(), 1, 151);
+        for(int i = 1; i < 151; i++) {
+          int r = y.rules[ States<nbStates>::index(prev[i-1], prev[i], prev[i+1]) ];
+          if (cur[i] != r)
+            nbDifferent++;
+          if (r == FIRE)
+            nbFire--;
+        }
+        if (nbFire != 0)
+          nbDifferent++;
+      }
+    }
+    RowKernel<nbStates>::setLevel(maxLevel);
+    kernel->~RowKernel<nbStates>();
+    delete [] buffer;
+
+    // expected value 0
+    std::cout << "rows of the heap kernel (" << RowKernel<nbStates>::name(maxLevel) << "): different cells " << nbDifferent << std::endl;
+}